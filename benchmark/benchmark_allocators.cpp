@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <vector>
+#include "customSTL/arena.hpp"
+#include "customSTL/object_pool.hpp"
+
+// Allocation cost of Arena and ObjectPool against malloc/free and new/delete.
+// Each iteration allocates state.range(0) objects and then frees all of them.
+
+namespace {
+    struct Order {
+        long id;
+        double price;
+        long quantity;
+        char symbol[8];
+    };
+}
+
+static void BM_ArenaAllocate(benchmark::State& state) {
+    const auto n = state.range(0);
+    CustomSTL::Arena arena(n * sizeof(Order));
+    for (auto _ : state) {
+        for (int64_t i = 0; i < n; ++i) {
+            benchmark::DoNotOptimize(arena.construct<Order>());
+        }
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ArenaAllocate)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+static void BM_MallocFree(benchmark::State& state) {
+    const auto n = state.range(0);
+    std::vector<void*> ptrs(n);
+    for (auto _ : state) {
+        for (int64_t i = 0; i < n; ++i) {
+            ptrs[i] = std::malloc(sizeof(Order));
+            benchmark::DoNotOptimize(ptrs[i]);
+        }
+        for (int64_t i = 0; i < n; ++i) {
+            std::free(ptrs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_MallocFree)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+static void BM_ObjectPoolAcquireRelease(benchmark::State& state) {
+    const auto n = state.range(0);
+    CustomSTL::ObjectPool<Order> pool(n);
+    std::vector<Order*> ptrs(n);
+    for (auto _ : state) {
+        for (int64_t i = 0; i < n; ++i) {
+            ptrs[i] = pool.acquire();
+            benchmark::DoNotOptimize(ptrs[i]);
+        }
+        for (int64_t i = 0; i < n; ++i) {
+            pool.release(ptrs[i]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ObjectPoolAcquireRelease)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+static void BM_NewDelete(benchmark::State& state) {
+    const auto n = state.range(0);
+    std::vector<Order*> ptrs(n);
+    for (auto _ : state) {
+        for (int64_t i = 0; i < n; ++i) {
+            ptrs[i] = new Order();
+            benchmark::DoNotOptimize(ptrs[i]);
+        }
+        for (int64_t i = 0; i < n; ++i) {
+            delete ptrs[i];
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_NewDelete)->RangeMultiplier(8)->Range(8, 1 << 15);
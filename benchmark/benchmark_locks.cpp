@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include "customSTL/distributed_shared_mutex.hpp"
+#include "customSTL/futex_mutex.hpp"
+#include "customSTL/lock_guard.hpp"
+#include "customSTL/shared_lock.hpp"
+#include "customSTL/spinlock.hpp"
+
+// glibc skips the atomic instructions of pthread mutexes while the process has never started a thread, which would
+// make the std mutexes look several times cheaper than in any real (multi-threaded) program
+static const bool process_is_multi_threaded = [] {
+    std::thread([] { }).join();
+    return true;
+}();
+
+// Uncontended cost of a lock()/unlock() pair
+template <typename Lock>
+static void BM_LockUncontended(benchmark::State& state) {
+    Lock lock;
+    int64_t counter = 0;
+    for (auto _ : state) {
+        CustomSTL::lock_guard<Lock> guard(lock);
+        benchmark::DoNotOptimize(++counter);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_LockUncontended, std::mutex);
+BENCHMARK_TEMPLATE(BM_LockUncontended, std::timed_mutex);
+BENCHMARK_TEMPLATE(BM_LockUncontended, CustomSTL::futex_mutex);
+BENCHMARK_TEMPLATE(BM_LockUncontended, CustomSTL::spinlock);
+BENCHMARK_TEMPLATE(BM_LockUncontended, CustomSTL::ticket_lock);
+BENCHMARK_TEMPLATE(BM_LockUncontended, CustomSTL::mcs_lock);
+
+// Handoff under contention: every thread increments the same counter under the lock, with a short critical section.
+// With more than one thread nearly every acquisition is a handoff from another core, so real time per item is the
+// average handoff latency. Fair locks (ticket, MCS) degrade sharply once there are more threads than cores.
+template <typename Lock>
+static void BM_LockHandoff(benchmark::State& state) {
+    static Lock lock;
+    static int64_t counter = 0;
+    for (auto _ : state) {
+        CustomSTL::lock_guard<Lock> guard(lock);
+        benchmark::DoNotOptimize(++counter);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_LockHandoff, std::mutex)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockHandoff, std::timed_mutex)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockHandoff, CustomSTL::futex_mutex)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockHandoff, CustomSTL::spinlock)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockHandoff, CustomSTL::ticket_lock)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockHandoff, CustomSTL::mcs_lock)->ThreadRange(1, 8)->UseRealTime();
+
+// Read side scaling of the reader-writer locks: every thread takes the shared lock, nobody writes.
+// std::shared_mutex updates one reader count shared by all cores, distributed_shared_mutex one slot per thread.
+template <typename SharedMutex>
+static void BM_SharedLockRead(benchmark::State& state) {
+    static SharedMutex mutex;
+    static int64_t value = 42;
+    for (auto _ : state) {
+        CustomSTL::shared_lock<SharedMutex> guard(mutex);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_SharedLockRead, std::shared_mutex)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SharedLockRead, CustomSTL::distributed_shared_mutex<>)->ThreadRange(1, 64)->UseRealTime();
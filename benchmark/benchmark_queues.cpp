@@ -0,0 +1,144 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "customSTL/seqlock.hpp"
+#include "customSTL/spscqueue.hpp"
+
+// Producer throughput while other threads consume concurrently.
+// The consumers are started outside of the timed loop, every iteration is one element pushed by the producer.
+
+static void BM_SPSCQueue(benchmark::State& state) {
+    static CustomSTL::SPSCQueue<int64_t, 1024> queue;
+    std::atomic<bool> stop { false };
+
+    std::thread consumer([&] {
+        int64_t value;
+        while (!stop.load(std::memory_order_relaxed)) {
+            while (queue.pop(value)) {
+                benchmark::DoNotOptimize(value);
+            }
+        }
+        while (queue.pop(value)) { }
+    });
+
+    int64_t i = 0;
+    for (auto _ : state) {
+        while (!queue.push(i)) { }
+        ++i;
+    }
+
+    stop.store(true, std::memory_order_relaxed);
+    consumer.join();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SPSCQueue)->UseRealTime();
+
+static void BM_MutexDeque(benchmark::State& state) {
+    std::mutex mutex;
+    std::deque<int64_t> queue;
+    std::atomic<bool> stop { false };
+
+    std::thread consumer([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (!queue.empty()) {
+                benchmark::DoNotOptimize(queue.front());
+                queue.pop_front();
+            }
+        }
+    });
+
+    int64_t i = 0;
+    for (auto _ : state) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(i++);
+    }
+
+    stop.store(true, std::memory_order_relaxed);
+    consumer.join();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MutexDeque)->UseRealTime();
+
+// Single writer with state.range(0) concurrent readers
+namespace {
+    struct Quote {
+        int64_t bid;
+        int64_t ask;
+        int64_t bid_size;
+        int64_t ask_size;
+    };
+}
+
+static void BM_SeqLockRingBufferPush(benchmark::State& state) {
+    static CustomSTL::SeqLockRingBuffer<Quote, 4096> buffer;
+    std::atomic<bool> stop { false };
+    std::atomic<int64_t> running { state.range(0) };
+
+    std::vector<std::thread> readers;
+    for (int64_t r = 0; r < state.range(0); ++r) {
+        readers.emplace_back([&] {
+            CustomSTL::SeqLockRingBuffer<Quote, 4096>::Reader reader(buffer);
+            Quote quote;
+            bool overrun;
+            while (!stop.load(std::memory_order_relaxed)) {
+                reader.read(quote, overrun);
+                benchmark::DoNotOptimize(quote);
+            }
+            running.fetch_sub(1, std::memory_order_relaxed);
+        });
+    }
+
+    int64_t i = 0;
+    for (auto _ : state) {
+        buffer.push(Quote { i, i + 1, 100, 100 });
+        ++i;
+    }
+
+    // readers block until the next slot is written, keep publishing until all of them have seen the stop flag
+    // (yielding after every push, otherwise a reader sharing our core keeps getting lapped and never returns)
+    stop.store(true, std::memory_order_relaxed);
+    while (running.load(std::memory_order_relaxed) > 0) {
+        buffer.push(Quote { i, i + 1, 100, 100 });
+        std::this_thread::yield();
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SeqLockRingBufferPush)->DenseRange(0, 4)->UseRealTime();
+
+static void BM_MutexLatestValuePush(benchmark::State& state) {
+    std::mutex mutex;
+    Quote latest {};
+    std::atomic<bool> stop { false };
+
+    std::vector<std::thread> readers;
+    for (int64_t r = 0; r < state.range(0); ++r) {
+        readers.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                benchmark::DoNotOptimize(latest);
+            }
+        });
+    }
+
+    int64_t i = 0;
+    for (auto _ : state) {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest = Quote { i, i + 1, 100, 100 };
+        ++i;
+    }
+
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MutexLatestValuePush)->DenseRange(0, 4)->UseRealTime();
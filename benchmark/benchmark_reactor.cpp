@@ -0,0 +1,304 @@
+#include <benchmark/benchmark.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <random>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+#include "network/epollreactor.hpp"
+#include "network/iouring.hpp"
+#include "network/multireactor.hpp"
+#include "network/outputbuffer.hpp"
+#include "network/timerwheel.hpp"
+#include "network/uringreactor.hpp"
+
+namespace {
+    struct DiscardHandler {
+        explicit DiscardHandler(std::atomic<long>* total)
+            : total_bytes { total }
+        { }
+
+        int on_data(int, void*, int size) {
+            total_bytes->fetch_add(size, std::memory_order_relaxed);
+            return size;
+        }
+
+        std::atomic<long>* total_bytes;
+    };
+
+    // answers every 16 byte request with a 16 byte response
+    struct EchoHandler {
+        int on_data(int, void* buf, int size, network::OutputBuffer& out) {
+            int complete = size - size % 16;
+            out.append(buf, complete);
+            return complete;
+        }
+    };
+
+    // counts messages framed by a 4 byte length, consumes only complete ones
+    struct FramedHandler {
+        explicit FramedHandler(std::atomic<long>* messages)
+            : total_messages { messages }
+        { }
+
+        int on_data(int, void* buf, int size) {
+            const char* bytes = static_cast<const char*>(buf);
+            int consumed = 0;
+            while (size - consumed >= 4) {
+                uint32_t length;
+                std::memcpy(&length, bytes + consumed, 4);
+                if (size - consumed - 4 < static_cast<int>(length)) {
+                    break;
+                }
+                consumed += 4 + length;
+                total_messages->fetch_add(1, std::memory_order_relaxed);
+            }
+            return consumed;
+        }
+
+        std::atomic<long>* total_messages;
+    };
+
+    int connect_to(const std::string& port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(std::stoi(port)));
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+}
+
+// Ingest throughput of a MultiReactor with state.range(0) reactors, fed by 8 client connections each sending
+// 64KB per iteration from its own thread. Scales with the number of reactors up to the number of cores.
+static void BM_MultiReactorIngest(benchmark::State& state) {
+    constexpr int CLIENTS = 8;
+    constexpr size_t CHUNK = 64 * 1024;
+
+    std::atomic<long> received { 0 };
+    network::MultiReactor<DiscardHandler> reactors("0", state.range(0), [&](size_t) { return DiscardHandler(&received); });
+    reactors.start();
+
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        clients.push_back(connect_to(reactors.get_port()));
+    }
+
+    std::vector<char> payload(CHUNK, 'x');
+    long sent = 0;
+    for (auto _ : state) {
+        std::vector<std::thread> senders;
+        for (int client : clients) {
+            senders.emplace_back([&, client] {
+                size_t offset = 0;
+                while (offset < CHUNK) {
+                    ssize_t rc = send(client, payload.data() + offset, CHUNK - offset, 0);
+                    if (rc <= 0) {
+                        break;
+                    }
+                    offset += rc;
+                }
+            });
+        }
+        for (auto& sender : senders) {
+            sender.join();
+        }
+        sent += CLIENTS * CHUNK;
+        while (received.load(std::memory_order_relaxed) < sent) {
+            std::this_thread::yield();
+        }
+    }
+
+    for (int client : clients) {
+        close(client);
+    }
+    reactors.stop();
+    reactors.join();
+    state.SetBytesProcessed(sent);
+}
+BENCHMARK(BM_MultiReactorIngest)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+
+// Pipelined request/response: the client sends state.range(0) 16 byte requests at once and waits for every response.
+// The reactor queues the responses of a batch in the connection's OutputBuffer and sends them with one sendmsg.
+template <typename Reactor>
+static void BM_ReactorPipelinedEcho(benchmark::State& state) {
+    if constexpr (std::is_same_v<Reactor, network::UringReactor<EchoHandler>>) {
+        if (!network::io_uring_supported()) {
+            state.SkipWithError("io_uring is not available");
+            return;
+        }
+    }
+
+    EchoHandler handler;
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    Reactor reactor(handler);
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    int client = connect_to(server.get_port());
+    std::vector<char> requests(state.range(0) * 16, 'r');
+    std::vector<char> responses(requests.size());
+    for (auto _ : state) {
+        send(client, requests.data(), requests.size(), 0);
+        size_t offset = 0;
+        while (offset < responses.size()) {
+            ssize_t rc = recv(client, responses.data() + offset, responses.size() - offset, 0);
+            if (rc <= 0) {
+                break;
+            }
+            offset += rc;
+        }
+    }
+
+    close(client);
+    reactor.stop();
+    loop.join();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    if constexpr (std::is_same_v<Reactor, network::UringReactor<EchoHandler>>) {
+        // the epoll reactor makes at least 3 syscalls per batch (epoll_wait, recv until EAGAIN, sendmsg)
+        state.counters["syscalls_per_batch"] = static_cast<double>(reactor.enter_calls()) / state.iterations();
+    }
+}
+BENCHMARK_TEMPLATE(BM_ReactorPipelinedEcho, network::EpollReactor<EchoHandler>)->RangeMultiplier(8)->Range(1, 512)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ReactorPipelinedEcho, network::UringReactor<EchoHandler>)->RangeMultiplier(8)->Range(1, 512)->UseRealTime();
+
+// One 16 byte request in flight at a time, with a busy poll budget of state.range(0) microseconds (0 blocks in
+// epoll_wait right away). Reports the median and 99th percentile round trip. Spinning only pays off when the reactor
+// has a core to itself: on a machine with fewer cores than threads it competes with the client for the CPU.
+static void BM_ReactorPingPongLatency(benchmark::State& state) {
+    EchoHandler handler;
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<EchoHandler> reactor(handler, { .busy_poll_budget = std::chrono::microseconds(state.range(0)) });
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    int client = connect_to(server.get_port());
+    char request[16] = {};
+    char response[16];
+    std::vector<double> round_trips;
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        send(client, request, sizeof(request), 0);
+        size_t offset = 0;
+        while (offset < sizeof(response)) {
+            ssize_t rc = recv(client, response + offset, sizeof(response) - offset, 0);
+            if (rc <= 0) {
+                break;
+            }
+            offset += rc;
+        }
+        round_trips.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    close(client);
+    reactor.stop();
+    loop.join();
+    std::sort(round_trips.begin(), round_trips.end());
+    state.counters["p50_us"] = round_trips[round_trips.size() / 2];
+    state.counters["p99_us"] = round_trips[round_trips.size() * 99 / 100];
+}
+BENCHMARK(BM_ReactorPingPongLatency)->Arg(0)->Arg(50)->UseRealTime();
+
+// Messages of state.range(0) bytes, received in many chunks before the handler can consume them. The unconsumed
+// bytes stay in place in the connection's mirrored input ring while the following chunks are received behind them.
+static void BM_ReactorLargeMessages(benchmark::State& state) {
+    std::atomic<long> messages { 0 };
+    FramedHandler handler(&messages);
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<FramedHandler> reactor(handler);
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    int client = connect_to(server.get_port());
+    std::vector<char> message(4 + state.range(0), 'm');
+    uint32_t length = state.range(0);
+    std::memcpy(message.data(), &length, 4);
+    long sent = 0;
+    for (auto _ : state) {
+        size_t offset = 0;
+        while (offset < message.size()) {
+            ssize_t rc = send(client, message.data() + offset, message.size() - offset, 0);
+            if (rc <= 0) {
+                break;
+            }
+            offset += rc;
+        }
+        ++sent;
+        while (messages.load(std::memory_order_relaxed) < sent) {
+            std::this_thread::yield();
+        }
+    }
+
+    close(client);
+    reactor.stop();
+    loop.join();
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ReactorLargeMessages)->RangeMultiplier(8)->Range(64 * 1024, 4 * 1024 * 1024)->UseRealTime();
+
+// Idle timeouts: state.range(0) pending timers, one of them pushed back by 30s per iteration (as on every message of
+// a connection), time moving by 1ms every 64 iterations. The timer wheel relinks a node in O(1), whatever the number
+// of timers, where an ordered map pays a tree erase and insert.
+static void BM_TimerWheelReschedule(benchmark::State& state) {
+    using namespace std::chrono_literals;
+    network::TimerWheel::Clock::time_point now {};
+    network::TimerWheel wheel(1ms, now);
+    std::vector<network::TimerWheel::TimerId> timers;
+    std::mt19937 random(42);
+    for (long i = 0; i < state.range(0); ++i) {
+        timers.push_back(wheel.schedule(std::chrono::milliseconds(30000 + random() % 1000), [] { }));
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        wheel.reschedule(timers[random() % timers.size()], 30s);
+        if (++i % 64 == 0) {
+            now += 1ms;
+            wheel.advance(now);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerWheelReschedule)->RangeMultiplier(32)->Range(1024, 1024 * 1024);
+
+static void BM_TimerMapReschedule(benchmark::State& state) {
+    using namespace std::chrono_literals;
+    using Map = std::multimap<network::TimerWheel::Clock::time_point, int>;
+    network::TimerWheel::Clock::time_point now {};
+    Map timers;
+    std::vector<Map::iterator> handles;
+    std::mt19937 random(42);
+    for (long i = 0; i < state.range(0); ++i) {
+        handles.push_back(timers.emplace(now + std::chrono::milliseconds(30000 + random() % 1000), 0));
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        Map::iterator& handle = handles[random() % handles.size()];
+        timers.erase(handle);
+        handle = timers.emplace(now + 30s, 0);
+        if (++i % 64 == 0) {
+            now += 1ms;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerMapReschedule)->RangeMultiplier(32)->Range(1024, 1024 * 1024);
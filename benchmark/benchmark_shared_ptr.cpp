@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <mutex>
+#include "customSTL/atomic_shared_ptr.hpp"
+#include "customSTL/shared_ptr.hpp"
+
+// Copy + destroy throughput for each reference counting policy.
+// Every iteration performs one increment and one decrement on the shared control block.
+
+template <typename Ptr>
+static void copy_and_destroy(benchmark::State& state, const Ptr& source) {
+    for (auto _ : state) {
+        Ptr copy = source;
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_SharedPtrAtomicCopy(benchmark::State& state) {
+    auto source = CustomSTL::make_shared<int>(42);
+    copy_and_destroy(state, source);
+}
+BENCHMARK(BM_SharedPtrAtomicCopy);
+
+static void BM_SharedPtrLocalCopy(benchmark::State& state) {
+    auto source = CustomSTL::make_local_shared<int>(42);
+    copy_and_destroy(state, source);
+}
+BENCHMARK(BM_SharedPtrLocalCopy);
+
+static void BM_StdSharedPtrCopy(benchmark::State& state) {
+    auto source = std::make_shared<int>(42);
+    copy_and_destroy(state, source);
+}
+BENCHMARK(BM_StdSharedPtrCopy);
+
+// The atomic policy under contention, every thread copies the same shared_ptr
+static void BM_SharedPtrAtomicCopyContended(benchmark::State& state) {
+    static CustomSTL::shared_ptr<int> source = CustomSTL::make_shared<int>(42);
+    copy_and_destroy(state, source);
+}
+BENCHMARK(BM_SharedPtrAtomicCopyContended)->ThreadRange(1, 8)->UseRealTime();
+
+// Scaling of the atomic and sharded policies: every thread keeps its own long lived handle on the same object
+// and copies from it, so the atomic policy bounces one cache line while the sharded one stays on the thread's shard
+template <typename Ptr>
+static void copy_from_own_handle(benchmark::State& state, const Ptr& shared) {
+    Ptr handle = shared;
+    copy_and_destroy(state, handle);
+}
+
+static void BM_SharedPtrAtomicCopyScaling(benchmark::State& state) {
+    static CustomSTL::shared_ptr<int> source = CustomSTL::make_shared<int>(42);
+    copy_from_own_handle(state, source);
+}
+BENCHMARK(BM_SharedPtrAtomicCopyScaling)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_SharedPtrShardedCopyScaling(benchmark::State& state) {
+    static CustomSTL::sharded_shared_ptr<int> source = CustomSTL::make_sharded_shared<int>(42);
+    copy_from_own_handle(state, source);
+}
+BENCHMARK(BM_SharedPtrShardedCopyScaling)->ThreadRange(1, 64)->UseRealTime();
+
+// Read side of a published snapshot: atomic_shared_ptr::load against a mutex protected shared_ptr
+static CustomSTL::atomic_shared_ptr<int> published_atomic { CustomSTL::make_shared<int>(42) };
+
+static void BM_AtomicSharedPtrLoad(benchmark::State& state) {
+    for (auto _ : state) {
+        auto snapshot = published_atomic.load();
+        benchmark::DoNotOptimize(snapshot);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AtomicSharedPtrLoad)->ThreadRange(1, 8)->UseRealTime();
+
+static std::mutex published_mutex;
+static CustomSTL::shared_ptr<int> published_locked = CustomSTL::make_shared<int>(42);
+
+static void BM_MutexSharedPtrLoad(benchmark::State& state) {
+    for (auto _ : state) {
+        CustomSTL::shared_ptr<int> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(published_mutex);
+            snapshot = published_locked;
+        }
+        benchmark::DoNotOptimize(snapshot);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MutexSharedPtrLoad)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include "customSTL/object_pool.hpp"
+#include "customSTL/unique_ptr.hpp"
+
+// Create + destroy cost of an owning handle, against std::unique_ptr and the pooled/inline alternatives.
+
+namespace {
+    struct Handler {
+        virtual ~Handler() = default;
+        virtual long on_data(long bytes) = 0;
+    };
+
+    struct EchoHandler : Handler {
+        long total = 0;
+        long on_data(long bytes) override { return total += bytes; }
+    };
+}
+
+static void BM_UniquePtrMakeUnique(benchmark::State& state) {
+    for (auto _ : state) {
+        auto ptr = CustomSTL::make_unique<long>(42);
+        benchmark::DoNotOptimize(ptr.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UniquePtrMakeUnique);
+
+static void BM_StdUniquePtrMakeUnique(benchmark::State& state) {
+    for (auto _ : state) {
+        auto ptr = std::make_unique<long>(42);
+        benchmark::DoNotOptimize(ptr.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StdUniquePtrMakeUnique);
+
+static void BM_UniquePtrFromPool(benchmark::State& state) {
+    CustomSTL::ObjectPool<long> pool(16);
+    for (auto _ : state) {
+        auto ptr = CustomSTL::make_unique_from(pool, 42);
+        benchmark::DoNotOptimize(ptr.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UniquePtrFromPool);
+
+// Polymorphic object: inline storage in small_unique_ptr against a heap allocated std::unique_ptr<Base>
+static void BM_SmallUniquePtrPolymorphic(benchmark::State& state) {
+    for (auto _ : state) {
+        auto handler = CustomSTL::make_small_unique<Handler, EchoHandler>();
+        benchmark::DoNotOptimize(handler->on_data(64));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SmallUniquePtrPolymorphic);
+
+static void BM_StdUniquePtrPolymorphic(benchmark::State& state) {
+    for (auto _ : state) {
+        std::unique_ptr<Handler> handler = std::make_unique<EchoHandler>();
+        benchmark::DoNotOptimize(handler->on_data(64));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StdUniquePtrPolymorphic);
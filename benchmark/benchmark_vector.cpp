@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "customSTL/vector.hpp"
+
+// push_back of state.range(0) elements into an empty vector, including every reallocation on the way
+
+template <typename Vector, typename T>
+static void push_back_n(benchmark::State& state, const T& value) {
+    const auto n = state.range(0);
+    for (auto _ : state) {
+        Vector v;
+        for (int64_t i = 0; i < n; ++i) {
+            v.push_back(value);
+        }
+        benchmark::DoNotOptimize(&v);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_VectorPushBackInt(benchmark::State& state) {
+    push_back_n<CustomSTL::vector<int>>(state, 42);
+}
+BENCHMARK(BM_VectorPushBackInt)->RangeMultiplier(8)->Range(8, 1 << 18);
+
+static void BM_StdVectorPushBackInt(benchmark::State& state) {
+    push_back_n<std::vector<int>>(state, 42);
+}
+BENCHMARK(BM_StdVectorPushBackInt)->RangeMultiplier(8)->Range(8, 1 << 18);
+
+static void BM_VectorPushBackString(benchmark::State& state) {
+    push_back_n<CustomSTL::vector<std::string>>(state, std::string(32, 'x'));
+}
+BENCHMARK(BM_VectorPushBackString)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+static void BM_StdVectorPushBackString(benchmark::State& state) {
+    push_back_n<std::vector<std::string>>(state, std::string(32, 'x'));
+}
+BENCHMARK(BM_StdVectorPushBackString)->RangeMultiplier(8)->Range(8, 1 << 15);
@@ -6,6 +6,8 @@
 #include <cstddef>
 #include <type_traits>
 
+#include "unique_ptr.hpp"
+
 namespace CustomSTL {
 
 // Class for a Bump Allocator
@@ -76,4 +78,54 @@ public:
     }
 };
 
-}
\ No newline at end of file
+// Allocator adapter so that containers/smart pointers (e.g. allocate_shared) can take their memory from an arena.
+// deallocate() is a no-op, the memory is only reclaimed when the arena is reset.
+// Destructors are still run by whoever owns the object, so T does not need to be trivially destructible.
+template <typename T>
+class arena_allocator {
+public:
+    using value_type = T;
+
+    explicit arena_allocator(Arena& arena) noexcept
+        : arena_ { &arena }
+    { }
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept
+        : arena_ { other.arena() }
+    { }
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept { }
+
+    Arena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const arena_allocator<U>& other) const noexcept { return arena_ == other.arena(); }
+
+private:
+    Arena* arena_;
+};
+
+// Deleter for objects constructed in an Arena: only runs the destructor, the memory is reclaimed by Arena::reset().
+// It does not need to know the arena, so unique_ptr<T, arena_deleter<T>> is the size of a raw pointer.
+template <typename T>
+struct arena_deleter {
+    void operator()(T* ptr) const noexcept { ptr->~T(); }
+};
+
+template <typename T>
+using arena_unique_ptr = unique_ptr<T, arena_deleter<T>>;
+
+// Unlike Arena::construct, T does not need to be trivially destructible as the unique_ptr runs its destructor.
+// The unique_ptr must be destroyed before the arena is reset.
+template <typename T, typename... Args>
+arena_unique_ptr<T> make_unique_from(Arena& arena, Args&&... args) {
+    void* memory = arena.allocate(sizeof(T), alignof(T));
+    return arena_unique_ptr<T>(new (memory) T(std::forward<Args>(args)...));
+}
+
+}
@@ -0,0 +1,203 @@
+#ifndef CUSTOM_STL_ATOMIC_SHARED_PTR_HPP
+#define CUSTOM_STL_ATOMIC_SHARED_PTR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+#include "shared_ptr.hpp"
+
+namespace CustomSTL {
+    /*
+    * Lock free atomic shared_ptr using split reference counts.
+    *
+    * Every stored value is wrapped in an immutable Node holding the shared_ptr<T> (so aliasing and converted pointers
+    * keep working without the ControlBlock having to know the element pointer). The atomic word packs the Node pointer
+    * in the lower 48 bits and a "local" count in the upper 16 bits.
+    *
+    * A reader borrows the current Node with a single fetch_add on the local count, copies the shared_ptr (this is what
+    * increments the ControlBlock's strong count) and then gives the borrow back by decrementing the local count again.
+    * A writer swaps in a new Node and transfers whatever local count it swapped out to the old Node's own count.
+    * Readers that find the Node was swapped out before they could give the borrow back decrement the Node's own
+    * count instead. Whoever brings the Node's count back to zero deletes it.
+    *
+    * Note: at most 2^16 - 1 threads may be in the middle of a load() at the same time.
+    */
+    template <typename T>
+    class atomic_shared_ptr {
+    public:
+        using value_type = shared_ptr<T>;
+
+    private:
+        struct Node {
+            // signed, as readers may give back their borrow before the writer transfers the local count
+            std::atomic<long> count { 0 };
+            shared_ptr<T> value;
+
+            explicit Node(shared_ptr<T>&& v) noexcept
+                : value { std::move(v) }
+            { }
+        };
+
+        static_assert(sizeof(void*) == 8, "atomic_shared_ptr packs a 48 bit pointer and a 16 bit count in one word");
+
+        static constexpr int COUNT_SHIFT = 48;
+        static constexpr uint64_t ONE_BORROW = uint64_t { 1 } << COUNT_SHIFT;
+        static constexpr uint64_t POINTER_MASK = ONE_BORROW - 1;
+
+        static Node* node_of(uint64_t word) noexcept { return reinterpret_cast<Node*>(word & POINTER_MASK); }
+        static long borrows_of(uint64_t word) noexcept { return static_cast<long>(word >> COUNT_SHIFT); }
+
+        static uint64_t pack(Node* node) noexcept { return reinterpret_cast<uint64_t>(node); }
+
+        // a null pointer may still own a control block (e.g. one created with a deleter), and a non null pointer may
+        // have none, so a value is only stored as the empty word when it has neither
+        static bool is_empty(const shared_ptr<T>& value) noexcept { return !value && value.use_count() == 0; }
+
+        static Node* make_node(shared_ptr<T>&& value) {
+            return is_empty(value) ? nullptr : new Node(std::move(value));
+        }
+
+        // adds delta to the node's own count, deleting the node if this brings it to zero
+        static void adjust(Node* node, long delta) noexcept {
+            if (node->count.fetch_add(delta, std::memory_order_acq_rel) + delta == 0) {
+                delete node;
+            }
+        }
+
+        // marks the node as in use so that it cannot be deleted while we read it
+        uint64_t borrow() const noexcept {
+            return word_.fetch_add(ONE_BORROW, std::memory_order_acquire) + ONE_BORROW;
+        }
+
+        // gives back a borrow obtained with borrow()
+        void give_back(uint64_t expected) const noexcept {
+            Node* node = node_of(expected);
+            while (true) {
+                if (node_of(expected) != node) {
+                    // the node was swapped out, the writer has moved our borrow onto the node's own count
+                    adjust(node, -1);
+                    return;
+                }
+
+                if (word_.compare_exchange_weak(expected, expected - ONE_BORROW, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+
+        // called by the thread that swapped out old_word, transfers all borrows made on it (minus our own) to the node
+        static void retire(uint64_t old_word, long own_borrows) noexcept {
+            if (Node* node = node_of(old_word)) {
+                adjust(node, borrows_of(old_word) - own_borrows);
+            }
+        }
+
+        mutable std::atomic<uint64_t> word_;
+
+    public:
+        constexpr atomic_shared_ptr() noexcept
+            : word_ { 0 }
+        { }
+
+        atomic_shared_ptr(shared_ptr<T> desired)
+            : word_ { pack(make_node(std::move(desired))) }
+        { }
+
+        ~atomic_shared_ptr() {
+            // nobody else may access the object while it is destroyed, so there are no outstanding borrows
+            delete node_of(word_.load(std::memory_order_acquire));
+        }
+
+        atomic_shared_ptr(const atomic_shared_ptr&) = delete;
+        atomic_shared_ptr& operator=(const atomic_shared_ptr&) = delete;
+
+        atomic_shared_ptr& operator=(shared_ptr<T> desired) {
+            store(std::move(desired));
+            return *this;
+        }
+
+        bool is_lock_free() const noexcept { return word_.is_lock_free(); }
+
+        shared_ptr<T> load() const noexcept {
+            uint64_t word = borrow();
+            Node* node = node_of(word);
+            if (node == nullptr) {
+                give_back(word);
+                return shared_ptr<T>();
+            }
+
+            shared_ptr<T> result = node->value;
+            give_back(word);
+            return result;
+        }
+
+        operator shared_ptr<T>() const noexcept { return load(); }
+
+        void store(shared_ptr<T> desired) {
+            exchange(std::move(desired));
+        }
+
+        shared_ptr<T> exchange(shared_ptr<T> desired) {
+            Node* new_node = make_node(std::move(desired));
+            uint64_t old_word = word_.exchange(pack(new_node), std::memory_order_acq_rel);
+
+            Node* old_node = node_of(old_word);
+            if (old_node == nullptr) {
+                return shared_ptr<T>();
+            }
+
+            // copy the value out before giving up the atomic's ownership of the node
+            shared_ptr<T> result = old_node->value;
+            retire(old_word, 0);
+            return result;
+        }
+
+        // Succeeds if the stored shared_ptr points to the same object and shares ownership with expected.
+        // On failure, expected is updated with the current value.
+        bool compare_exchange_strong(shared_ptr<T>& expected, shared_ptr<T> desired) {
+            Node* new_node = nullptr;
+
+            while (true) {
+                uint64_t word = borrow();
+                Node* node = node_of(word);
+
+                bool equal;
+                if (node == nullptr) {
+                    equal = is_empty(expected);
+                } else {
+                    const shared_ptr<T>& current = node->value;
+                    equal = current.get() == expected.get() && !current.owner_before(expected) && !expected.owner_before(current);
+                }
+
+                if (!equal) {
+                    shared_ptr<T> actual = node ? node->value : shared_ptr<T>();
+                    give_back(word);
+                    expected = std::move(actual);
+                    delete new_node;
+                    return false;
+                }
+
+                if (new_node == nullptr && !is_empty(desired)) {
+                    new_node = make_node(std::move(desired));
+                }
+
+                uint64_t observed = word;
+                if (word_.compare_exchange_strong(observed, pack(new_node), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    // our own borrow is included in the local count but we never give it back
+                    retire(word, 1);
+                    return true;
+                }
+
+                // another reader borrowed/returned or a writer swapped the value, try again
+                give_back(word);
+            }
+        }
+
+        bool compare_exchange_weak(shared_ptr<T>& expected, shared_ptr<T> desired) {
+            return compare_exchange_strong(expected, std::move(desired));
+        }
+    };
+}
+
+#endif
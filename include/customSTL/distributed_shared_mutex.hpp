@@ -0,0 +1,161 @@
+#ifndef CUSTOM_STL_DISTRIBUTED_SHARED_MUTEX_HPP
+#define CUSTOM_STL_DISTRIBUTED_SHARED_MUTEX_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "ref_count_policy.hpp" // for this_thread_shard
+#include "spinlock.hpp"
+
+namespace CustomSTL {
+
+/*
+* Reader-writer lock for read mostly data, with one padded reader count per thread slot instead of the single
+* reader count of std::shared_mutex. A reader only increments the slot of its own thread, so concurrent readers on
+* different cores never write to the same cache line, and read throughput scales with the number of cores.
+* Writers pay for it: they raise writer_ and then wait until every one of the ReaderSlots slots has drained.
+*
+* Writer preference: once a writer raised writer_, new readers back off until it is done, so a steady stream of
+* readers cannot starve writers. As a consequence, a thread must not take the shared lock recursively, as a writer
+* arriving in between would deadlock with it.
+*
+* Threads are assigned slots round robin (this_thread_shard), threads sharing a slot only share a counter.
+* Waiting is done by spinning with exponential_backoff.
+*/
+template <size_t ReaderSlots = 64>
+class distributed_shared_mutex {
+public:
+    distributed_shared_mutex() noexcept = default;
+
+    distributed_shared_mutex(const distributed_shared_mutex&) = delete;
+    distributed_shared_mutex& operator=(const distributed_shared_mutex&) = delete;
+
+    void lock() noexcept {
+        exponential_backoff backoff;
+        while (!try_raise_writer()) {
+            backoff.pause();
+        }
+
+        backoff.reset();
+        while (!readers_drained()) {
+            backoff.pause();
+        }
+    }
+
+    bool try_lock() noexcept {
+        if (!try_raise_writer()) {
+            return false;
+        }
+        if (!readers_drained()) {
+            writer_.store(false, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout_duration);
+    }
+
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        exponential_backoff backoff;
+        while (!try_raise_writer()) {
+            if (Clock::now() >= timeout_time) {
+                return false;
+            }
+            backoff.pause();
+        }
+
+        backoff.reset();
+        while (!readers_drained()) {
+            if (Clock::now() >= timeout_time) {
+                writer_.store(false, std::memory_order_release);
+                return false;
+            }
+            backoff.pause();
+        }
+        return true;
+    }
+
+    void unlock() noexcept { writer_.store(false, std::memory_order_release); }
+
+    void lock_shared() noexcept {
+        exponential_backoff backoff;
+        while (!try_lock_shared()) {
+            backoff.pause();
+        }
+    }
+
+    bool try_lock_shared() noexcept {
+        if (writer_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        // Dekker style handshake with lock(): the reader publishes itself then checks writer_, the writer publishes
+        // writer_ then checks the slots, both seq_cst, so at least one of them sees the other
+        std::atomic<uint32_t>& readers = own_slot();
+        readers.fetch_add(1, std::memory_order_seq_cst);
+        if (writer_.load(std::memory_order_seq_cst)) {
+            readers.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_lock_shared_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
+        return try_lock_shared_until(std::chrono::steady_clock::now() + timeout_duration);
+    }
+
+    template <typename Clock, typename Duration>
+    bool try_lock_shared_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        exponential_backoff backoff;
+        do {
+            if (try_lock_shared()) {
+                return true;
+            }
+            backoff.pause();
+        } while (Clock::now() < timeout_time);
+        return false;
+    }
+
+    // release so that the reads of the critical section happen before a writer sees the slot drained
+    void unlock_shared() noexcept { own_slot().fetch_sub(1, std::memory_order_release); }
+
+    static constexpr size_t reader_slots() noexcept { return ReaderSlots; }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> readers { 0 };
+    };
+
+    bool try_raise_writer() noexcept {
+        if (writer_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        bool expected = false;
+        return writer_.compare_exchange_strong(expected, true, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    bool readers_drained() const noexcept {
+        for (const Slot& slot : slots_) {
+            if (slot.readers.load(std::memory_order_seq_cst) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::atomic<uint32_t>& own_slot() noexcept { return slots_[this_thread_shard() % ReaderSlots].readers; }
+
+    alignas(64) std::atomic<bool> writer_ { false };
+    Slot slots_[ReaderSlots];
+};
+
+} // namespace CustomSTL
+
+#endif
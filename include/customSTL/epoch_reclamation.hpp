@@ -0,0 +1,242 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "object_pool.hpp"
+
+namespace CustomSTL {
+
+// A retired node together with how to reclaim it.
+// Type erased so that a single retire list can hold nodes of different types and reclaim them in different ways.
+struct RetiredNode {
+    void* ptr;
+    void (*reclaim)(void* ptr, void* context) noexcept;
+    void* context;
+    uint64_t epoch; // only used by epoch based reclamation
+
+    template <typename T>
+    static RetiredNode deleting(T* ptr) noexcept {
+        return { ptr, [](void* p, void*) noexcept { delete static_cast<T*>(p); }, nullptr, 0 };
+    }
+
+    // NOTE: ObjectPool is not thread safe. Reclamation normally runs on the thread that retired the node, but nodes
+    // left behind by a destroyed participant are adopted by another one, so the pool must be externally synchronized
+    // unless every participant using it outlives its retired nodes.
+    template <typename T>
+    static RetiredNode pooled(T* ptr, ObjectPool<T>& pool) noexcept {
+        return { ptr, [](void* p, void* c) noexcept { static_cast<ObjectPool<T>*>(c)->release(static_cast<T*>(p)); }, &pool, 0 };
+    }
+
+    void operator()() const noexcept { reclaim(ptr, context); }
+};
+
+/*
+* Epoch based reclamation (EBR).
+* Readers pin the current global epoch for the duration of a critical section.
+* A retired node is tagged with the global epoch at the time it was retired, and it can be reclaimed once the
+* global epoch has advanced twice since then: the epoch can only advance when every pinned thread has observed
+* the current epoch, so after two advances no thread can still be holding a reference obtained before the retire.
+* Reads are very cheap (one store + fence per critical section), but one stalled reader blocks all reclamation.
+*
+* Each thread that accesses the data structure creates its own Participant, similar to SeqLockRingBuffer::Reader.
+*/
+class EpochDomain {
+private:
+    static constexpr uint64_t INACTIVE = std::numeric_limits<uint64_t>::max();
+
+    struct alignas(64) Record {
+        std::atomic<uint64_t> epoch { INACTIVE };
+        std::atomic<bool> in_use { false };
+    };
+
+    alignas(64) std::atomic<uint64_t> global_epoch_ { 0 };
+    std::unique_ptr<Record[]> records_;
+    size_t max_participants_;
+
+    // nodes left behind by participants that were destroyed before they could reclaim them
+    std::mutex orphans_mutex_;
+    std::vector<RetiredNode> orphans_;
+
+public:
+    explicit EpochDomain(size_t max_participants = 128)
+        : records_ { std::make_unique<Record[]>(max_participants) }
+        , max_participants_ { max_participants }
+    { }
+
+    // all participants must be destroyed before the domain, so nobody can be reading anymore
+    ~EpochDomain() {
+        for (RetiredNode& node : orphans_) {
+            node();
+        }
+    }
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    uint64_t epoch() const noexcept { return global_epoch_.load(std::memory_order_acquire); }
+
+    class Participant;
+
+    // RAII critical section, pointers read from the protected data structure stay valid until the guard is destroyed
+    class Guard {
+    public:
+        explicit Guard(Participant& participant) noexcept
+            : participant_ { &participant }
+        {
+            participant_->enter();
+        }
+
+        ~Guard() {
+            if (participant_) {
+                participant_->leave();
+            }
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        Guard(Guard&& other) noexcept
+            : participant_ { std::exchange(other.participant_, nullptr) }
+        { }
+
+        Guard& operator=(Guard&&) = delete;
+
+    private:
+        Participant* participant_;
+    };
+
+    class Participant {
+    public:
+        // batch_size is the number of retired nodes that are accumulated before we try to reclaim them
+        explicit Participant(EpochDomain& domain, size_t batch_size = 64)
+            : domain_ { domain }
+            , record_ { domain.acquire_record() }
+            , batch_size_ { batch_size }
+        {
+            retired_.reserve(batch_size_);
+        }
+
+        ~Participant() {
+            reclaim();
+            if (!retired_.empty()) {
+                std::lock_guard<std::mutex> lock(domain_.orphans_mutex_);
+                domain_.orphans_.insert(domain_.orphans_.end(), retired_.begin(), retired_.end());
+            }
+            record_->epoch.store(INACTIVE, std::memory_order_release);
+            record_->in_use.store(false, std::memory_order_release);
+        }
+
+        Participant(const Participant&) = delete;
+        Participant& operator=(const Participant&) = delete;
+
+        [[nodiscard]] Guard pin() noexcept { return Guard(*this); }
+
+        template <typename T>
+        void retire(T* ptr) {
+            retire(RetiredNode::deleting(ptr));
+        }
+
+        // reclaimed nodes are handed back to pool instead of being deleted
+        template <typename T>
+        void retire(T* ptr, ObjectPool<T>& pool) {
+            retire(RetiredNode::pooled(ptr, pool));
+        }
+
+        void retire(RetiredNode node) {
+            node.epoch = domain_.global_epoch_.load(std::memory_order_acquire);
+            retired_.push_back(node);
+
+            if (retired_.size() >= batch_size_) {
+                reclaim();
+            }
+        }
+
+        // Tries to advance the global epoch and reclaims every node retired at least two epochs ago
+        void reclaim() {
+            domain_.try_advance();
+            adopt_orphans();
+
+            uint64_t safe_epoch = domain_.global_epoch_.load(std::memory_order_acquire);
+            std::erase_if(retired_, [safe_epoch](const RetiredNode& node) {
+                if (node.epoch + 2 <= safe_epoch) {
+                    node();
+                    return true;
+                }
+                return false;
+            });
+        }
+
+        size_t pending() const noexcept { return retired_.size(); }
+
+    private:
+        friend class Guard;
+
+        void enter() noexcept {
+            // critical sections may be nested, only the outermost one announces the epoch
+            if (depth_++ == 0) {
+                record_->epoch.store(domain_.global_epoch_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                // The announcement must be visible before we read any shared pointer. A seq_cst store would not be
+                // enough: the pointers are read with acquire/relaxed loads, which may still be ordered before it.
+                // Pairs with the fence in try_advance(): either it sees our epoch, or we see the pointer unlinked.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+
+        void leave() noexcept {
+            if (--depth_ == 0) {
+                record_->epoch.store(INACTIVE, std::memory_order_release);
+            }
+        }
+
+        void adopt_orphans() {
+            std::unique_lock<std::mutex> lock(domain_.orphans_mutex_, std::try_to_lock);
+            if (lock.owns_lock() && !domain_.orphans_.empty()) {
+                retired_.insert(retired_.end(), domain_.orphans_.begin(), domain_.orphans_.end());
+                domain_.orphans_.clear();
+            }
+        }
+
+        EpochDomain& domain_;
+        Record* record_;
+        size_t batch_size_;
+        size_t depth_ = 0;
+        std::vector<RetiredNode> retired_;
+    };
+
+private:
+    Record* acquire_record() {
+        for (size_t i = 0; i < max_participants_; ++i) {
+            bool expected = false;
+            if (!records_[i].in_use.load(std::memory_order_relaxed) &&
+                records_[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return &records_[i];
+            }
+        }
+        throw std::runtime_error("EpochDomain has no free participant slots");
+    }
+
+    // The epoch can only advance once every pinned participant has observed the current epoch
+    void try_advance() noexcept {
+        // orders the unlinking of the nodes we retired before the reads of the announcements, see Participant::enter()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t current = global_epoch_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < max_participants_; ++i) {
+            // acquire pairs with the release in leave(), so a finished critical section is done with its pointers
+            uint64_t observed = records_[i].epoch.load(std::memory_order_acquire);
+            if (observed != INACTIVE && observed != current) {
+                return;
+            }
+        }
+        global_epoch_.compare_exchange_strong(current, current + 1, std::memory_order_acq_rel);
+    }
+};
+
+} // namespace CustomSTL
@@ -0,0 +1,138 @@
+#ifndef CUSTOM_STL_FUTEX_MUTEX_HPP
+#define CUSTOM_STL_FUTEX_MUTEX_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <immintrin.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace CustomSTL {
+
+/*
+* Linux futex based mutex with timed locking, the size of a single 32 bit word.
+* Three states (Drepper, "Futexes Are Tricky"): UNLOCKED, LOCKED (nobody sleeping) and CONTENDED (there may be
+* sleepers). The uncontended paths are a single CAS to lock and a single exchange to unlock, with no system call:
+* unlock only calls FUTEX_WAKE when the state says someone may be sleeping.
+*
+* Adaptive spinning: a thread that finds the lock LOCKED spins briefly, as the holder is likely running and about to
+* release it, but once the lock is CONTENDED other threads already gave up spinning, so it goes straight to sleep.
+* Unlock wakes a single waiter, which retakes the lock as CONTENDED (it cannot know if others still sleep), so a
+* release never wakes every waiter at once.
+*/
+class futex_mutex {
+public:
+    futex_mutex() noexcept = default;
+
+    futex_mutex(const futex_mutex&) = delete;
+    futex_mutex& operator=(const futex_mutex&) = delete;
+
+    void lock() noexcept {
+        uint32_t state = UNLOCKED;
+        if (state_.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+        }
+        lock_contended(state, nullptr);
+    }
+
+    bool try_lock() noexcept {
+        uint32_t state = UNLOCKED;
+        return state_.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout_duration);
+    }
+
+    // The futex sleeps against CLOCK_MONOTONIC (steady_clock), a deadline on another clock is re-checked on wakeup
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        uint32_t state = UNLOCKED;
+        if (state_.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return true;
+        }
+
+        while (true) {
+            auto remaining = timeout_time - Clock::now();
+            if (remaining <= decltype(remaining)::zero()) {
+                return try_lock();
+            }
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::ceil<std::chrono::nanoseconds>(remaining);
+            if (lock_contended(state, &deadline)) {
+                return true;
+            }
+            if constexpr (std::is_same_v<Clock, std::chrono::steady_clock>) {
+                return false;
+            }
+            state = state_.load(std::memory_order_relaxed);
+        }
+    }
+
+    void unlock() noexcept {
+        if (state_.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+            futex(FUTEX_WAKE_PRIVATE, 1, nullptr);
+        }
+    }
+
+private:
+    static constexpr uint32_t UNLOCKED = 0;
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t CONTENDED = 2;
+    static constexpr int SPIN_LIMIT = 100;
+
+    long futex(int op, uint32_t value, const timespec* timeout) noexcept {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state_), op, value, timeout, nullptr, FUTEX_BITSET_MATCH_ANY);
+    }
+
+    // Returns false if the deadline passed before the lock could be taken
+    bool lock_contended(uint32_t state, const std::chrono::steady_clock::time_point* deadline) noexcept {
+        for (int spins = 0; state == LOCKED && spins < SPIN_LIMIT; ++spins) {
+            _mm_pause();
+            state = state_.load(std::memory_order_relaxed);
+            if (state == UNLOCKED &&
+                state_.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+
+        timespec timeout {};
+        if (deadline != nullptr) {
+            auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline->time_since_epoch()).count();
+            timeout.tv_sec = since_epoch / 1'000'000'000;
+            timeout.tv_nsec = since_epoch % 1'000'000'000;
+        }
+
+        // from here on we may sleep, so the lock is marked CONTENDED to make sure the holder wakes somebody up
+        while (state_.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+            if (deadline == nullptr) {
+                futex(FUTEX_WAIT_PRIVATE, CONTENDED, nullptr);
+            } else if (futex(FUTEX_WAIT_BITSET_PRIVATE, CONTENDED, &timeout) == -1 && errno == ETIMEDOUT) {
+                // sleeping waiters may have set CONTENDED too, we cannot go back to LOCKED: worst case the holder
+                // makes one unnecessary wake call
+                return try_lock_after_timeout();
+            }
+        }
+        return true;
+    }
+
+    bool try_lock_after_timeout() noexcept {
+        uint32_t state = UNLOCKED;
+        return state_.compare_exchange_strong(state, CONTENDED, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    // the kernel reads the futex word directly
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free);
+
+    std::atomic<uint32_t> state_ { UNLOCKED };
+};
+
+} // namespace CustomSTL
+
+#endif
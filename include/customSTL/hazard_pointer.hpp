@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "epoch_reclamation.hpp" // for RetiredNode
+#include "object_pool.hpp"
+
+namespace CustomSTL {
+
+/*
+* Hazard pointer based reclamation.
+* Before dereferencing a shared pointer, a reader publishes it in one of its hazard slots and re-checks that the
+* pointer is still reachable. A retired node is only reclaimed once no hazard slot holds its address.
+* Compared to EpochDomain, every protected load costs a full fence, but a stalled reader only prevents the
+* few nodes it protects from being reclaimed instead of blocking all reclamation.
+*
+* Each thread creates its own Participant, which owns SlotsPerParticipant hazard slots and a retire list.
+*/
+template <size_t SlotsPerParticipant = 4>
+class HazardPointerDomain {
+private:
+    struct alignas(64) Record {
+        std::atomic<void*> hazards[SlotsPerParticipant] {};
+        std::atomic<bool> in_use { false };
+    };
+
+    std::unique_ptr<Record[]> records_;
+    size_t max_participants_;
+
+    // nodes left behind by participants that were destroyed while their nodes were still protected
+    std::mutex orphans_mutex_;
+    std::vector<RetiredNode> orphans_;
+
+public:
+    explicit HazardPointerDomain(size_t max_participants = 128)
+        : records_ { std::make_unique<Record[]>(max_participants) }
+        , max_participants_ { max_participants }
+    { }
+
+    // all participants must be destroyed before the domain, so nothing can be protected anymore
+    ~HazardPointerDomain() {
+        for (RetiredNode& node : orphans_) {
+            node();
+        }
+    }
+
+    HazardPointerDomain(const HazardPointerDomain&) = delete;
+    HazardPointerDomain& operator=(const HazardPointerDomain&) = delete;
+
+    class Participant;
+
+    // RAII ownership of a single hazard slot, the slot is cleared when the guard is destroyed
+    class Guard {
+    public:
+        Guard(std::atomic<void*>& slot, Participant& owner) noexcept
+            : slot_ { &slot }
+            , owner_ { &owner }
+        { }
+
+        ~Guard() {
+            if (slot_) {
+                slot_->store(nullptr, std::memory_order_release);
+                owner_->free_slot(slot_);
+            }
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        Guard(Guard&& other) noexcept
+            : slot_ { std::exchange(other.slot_, nullptr) }
+            , owner_ { other.owner_ }
+        { }
+
+        Guard& operator=(Guard&&) = delete;
+
+        // Loads src and protects the loaded pointer. The returned pointer stays valid until the guard is reset,
+        // reused or destroyed, even if it is concurrently unlinked and retired.
+        template <typename T>
+        T* protect(const std::atomic<T*>& src) noexcept {
+            T* ptr = src.load(std::memory_order_relaxed);
+            while (true) {
+                slot_->store(ptr, std::memory_order_relaxed);
+                // The fence keeps the reload below from being ordered before the hazard store, which a seq_cst store
+                // alone does not guarantee for an acquire load. It pairs with the fence in scan(): if src still holds
+                // ptr after publishing the hazard, a scan that follows the unlink of ptr sees our hazard.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                T* reloaded = src.load(std::memory_order_acquire);
+                if (reloaded == ptr) {
+                    return ptr;
+                }
+                ptr = reloaded;
+            }
+        }
+
+        void reset() noexcept { slot_->store(nullptr, std::memory_order_release); }
+
+    private:
+        std::atomic<void*>* slot_;
+        Participant* owner_;
+    };
+
+    class Participant {
+    public:
+        // batch_size is the number of retired nodes that are accumulated before scanning the hazard slots
+        explicit Participant(HazardPointerDomain& domain, size_t batch_size = 64)
+            : domain_ { domain }
+            , record_ { domain.acquire_record() }
+            , batch_size_ { batch_size }
+        {
+            retired_.reserve(batch_size_);
+        }
+
+        ~Participant() {
+            scan();
+            if (!retired_.empty()) {
+                std::lock_guard<std::mutex> lock(domain_.orphans_mutex_);
+                domain_.orphans_.insert(domain_.orphans_.end(), retired_.begin(), retired_.end());
+            }
+            record_->in_use.store(false, std::memory_order_release);
+        }
+
+        Participant(const Participant&) = delete;
+        Participant& operator=(const Participant&) = delete;
+
+        [[nodiscard]] Guard make_guard() {
+            for (size_t i = 0; i < SlotsPerParticipant; ++i) {
+                if ((used_slots_ & (1u << i)) == 0) {
+                    used_slots_ |= 1u << i;
+                    return Guard(record_->hazards[i], *this);
+                }
+            }
+            throw std::runtime_error("Participant has no free hazard slots");
+        }
+
+        template <typename T>
+        void retire(T* ptr) {
+            retire(RetiredNode::deleting(ptr));
+        }
+
+        // reclaimed nodes are handed back to pool instead of being deleted
+        template <typename T>
+        void retire(T* ptr, ObjectPool<T>& pool) {
+            retire(RetiredNode::pooled(ptr, pool));
+        }
+
+        void retire(RetiredNode node) {
+            retired_.push_back(node);
+            if (retired_.size() >= batch_size_) {
+                scan();
+            }
+        }
+
+        // Reclaims every retired node that is not protected by any hazard slot
+        void scan() {
+            adopt_orphans();
+
+            // a single pass over all slots, then a binary search per retired node: O(R log H)
+            std::vector<void*> hazards;
+            hazards.reserve(domain_.max_participants_ * SlotsPerParticipant);
+            // orders the unlinking of the retired nodes before the reads of the hazards, see Guard::protect()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (size_t i = 0; i < domain_.max_participants_; ++i) {
+                for (auto& hazard : domain_.records_[i].hazards) {
+                    // acquire pairs with the release that clears a slot, so its reader is done with the node
+                    if (void* ptr = hazard.load(std::memory_order_acquire)) {
+                        hazards.push_back(ptr);
+                    }
+                }
+            }
+            std::sort(hazards.begin(), hazards.end());
+
+            std::erase_if(retired_, [&hazards](const RetiredNode& node) {
+                if (!std::binary_search(hazards.begin(), hazards.end(), node.ptr)) {
+                    node();
+                    return true;
+                }
+                return false;
+            });
+        }
+
+        size_t pending() const noexcept { return retired_.size(); }
+
+    private:
+        friend class Guard;
+
+        void free_slot(std::atomic<void*>* slot) noexcept {
+            used_slots_ &= ~(1u << (slot - record_->hazards));
+        }
+
+        void adopt_orphans() {
+            std::unique_lock<std::mutex> lock(domain_.orphans_mutex_, std::try_to_lock);
+            if (lock.owns_lock() && !domain_.orphans_.empty()) {
+                retired_.insert(retired_.end(), domain_.orphans_.begin(), domain_.orphans_.end());
+                domain_.orphans_.clear();
+            }
+        }
+
+        HazardPointerDomain& domain_;
+        Record* record_;
+        size_t batch_size_;
+        unsigned used_slots_ = 0;
+        std::vector<RetiredNode> retired_;
+    };
+
+private:
+    static_assert(SlotsPerParticipant <= 32, "hazard slots are tracked in a 32 bit mask");
+
+    Record* acquire_record() {
+        for (size_t i = 0; i < max_participants_; ++i) {
+            bool expected = false;
+            if (!records_[i].in_use.load(std::memory_order_relaxed) &&
+                records_[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return &records_[i];
+            }
+        }
+        throw std::runtime_error("HazardPointerDomain has no free participant slots");
+    }
+};
+
+} // namespace CustomSTL
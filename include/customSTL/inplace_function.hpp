@@ -0,0 +1,172 @@
+#ifndef CUSTOM_STL_INPLACE_FUNCTION_HPP
+#define CUSTOM_STL_INPLACE_FUNCTION_HPP
+
+#include <concepts>
+#include <cstddef>
+#include <functional> // For std::invoke & std::bad_function_call
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "unique_ptr.hpp" // For SmallObjectOperations
+
+namespace CustomSTL {
+
+    template <typename Signature, std::size_t Capacity, bool Copyable>
+    class basic_inplace_function;
+
+    /*
+    * Callable wrapper that never allocates.
+    * The callable is always stored in the Capacity byte inline buffer, using the same type erased relocation as
+    * small_unique_ptr, but there is no heap fallback: a callable that does not fit is a compile time error.
+    * Copyable = false gives a move-only wrapper, which can hold move-only callables (e.g. capturing a unique_ptr).
+    */
+    template <typename R, typename... Args, std::size_t Capacity, bool Copyable>
+    class basic_inplace_function<R(Args...), Capacity, Copyable> {
+    private:
+        struct Operations {
+            SmallObjectOperations object;
+            R (*invoke)(void* storage, Args&&... args);
+            void (*copy)(void* dst_storage, const void* src_storage); // only used when Copyable
+        };
+
+        template <typename F>
+        static R invoke(void* storage, Args&&... args) {
+            return std::invoke(*std::launder(static_cast<F*>(storage)), std::forward<Args>(args)...);
+        }
+
+        template <typename F>
+        static void copy(void* dst_storage, const void* src_storage) {
+            ::new (dst_storage) F(*std::launder(static_cast<const F*>(src_storage)));
+        }
+
+        template <typename F>
+        static constexpr auto copy_operation() noexcept -> void (*)(void*, const void*) {
+            if constexpr (Copyable) {
+                return &copy<F>;
+            } else {
+                return nullptr;
+            }
+        }
+
+        template <typename F>
+        static constexpr Operations operations_for {
+            inline_object_operations<F>,
+            &invoke<F>,
+            copy_operation<F>()
+        };
+
+        const Operations* operations_;
+        alignas(std::max_align_t) mutable std::byte buffer_[Capacity];
+
+    public:
+        using result_type = R;
+
+        basic_inplace_function() noexcept
+            : operations_ { nullptr }
+        { }
+
+        basic_inplace_function(std::nullptr_t) noexcept
+            : basic_inplace_function()
+        { }
+
+        template <typename F, typename Fn = std::decay_t<F>>
+        requires (!std::same_as<Fn, basic_inplace_function>) && std::is_invocable_r_v<R, Fn&, Args...>
+        basic_inplace_function(F&& callable)
+            : basic_inplace_function()
+        {
+            static_assert(sizeof(Fn) <= Capacity, "callable does not fit in the inplace_function buffer, increase Capacity");
+            static_assert(alignof(Fn) <= alignof(std::max_align_t), "callable is over aligned for the inplace_function buffer");
+            static_assert(std::is_nothrow_move_constructible_v<Fn>, "callable must be nothrow move constructible");
+            static_assert(!Copyable || std::is_copy_constructible_v<Fn>, "move-only callable, use inplace_move_only_function");
+
+            ::new (static_cast<void*>(buffer_)) Fn(std::forward<F>(callable));
+            operations_ = &operations_for<Fn>;
+        }
+
+        basic_inplace_function(const basic_inplace_function& other)
+            requires Copyable
+            : operations_ { other.operations_ }
+        {
+            if (operations_) {
+                operations_->copy(buffer_, other.buffer_);
+            }
+        }
+
+        basic_inplace_function(basic_inplace_function&& other) noexcept
+            : operations_ { std::exchange(other.operations_, nullptr) }
+        {
+            if (operations_) {
+                operations_->object.relocate(buffer_, other.buffer_);
+            }
+        }
+
+        ~basic_inplace_function() noexcept {
+            reset();
+        }
+
+        basic_inplace_function& operator=(const basic_inplace_function& other)
+            requires Copyable
+        {
+            if (this != &other) {
+                basic_inplace_function(other).swap(*this);
+            }
+            return *this;
+        }
+
+        basic_inplace_function& operator=(basic_inplace_function&& other) noexcept {
+            if (this != &other) {
+                reset();
+                operations_ = std::exchange(other.operations_, nullptr);
+                if (operations_) {
+                    operations_->object.relocate(buffer_, other.buffer_);
+                }
+            }
+            return *this;
+        }
+
+        basic_inplace_function& operator=(std::nullptr_t) noexcept {
+            reset();
+            return *this;
+        }
+
+        template <typename F>
+        requires (!std::same_as<std::decay_t<F>, basic_inplace_function>) && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>
+        basic_inplace_function& operator=(F&& callable) {
+            basic_inplace_function(std::forward<F>(callable)).swap(*this);
+            return *this;
+        }
+
+        void swap(basic_inplace_function& other) noexcept {
+            basic_inplace_function tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+        void reset() noexcept {
+            if (operations_) {
+                operations_->object.destroy(buffer_);
+                operations_ = nullptr;
+            }
+        }
+
+        static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+        explicit operator bool() const noexcept { return operations_ != nullptr; }
+
+        R operator()(Args... args) const {
+            if (!operations_) {
+                throw std::bad_function_call();
+            }
+            return operations_->invoke(buffer_, std::forward<Args>(args)...);
+        }
+    };
+
+    template <typename Signature, std::size_t Capacity = 64>
+    using inplace_function = basic_inplace_function<Signature, Capacity, true>;
+
+    template <typename Signature, std::size_t Capacity = 64>
+    using inplace_move_only_function = basic_inplace_function<Signature, Capacity, false>;
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef CUSTOM_STL_INTRUSIVE_PTR_HPP
+#define CUSTOM_STL_INTRUSIVE_PTR_HPP
+
+#include <concepts>
+#include <cstddef>
+#include <utility>
+
+#include "ref_count_policy.hpp"
+
+namespace CustomSTL {
+    template <typename Derived>
+    concept HasLastReleaseHook = requires(Derived* obj) {
+        { obj->on_last_release() } noexcept;
+    };
+
+    // CRTP base that embeds the reference count inside the object, so that intrusive_ptr<Derived> only needs to store
+    // a single pointer and never touches a separate control block.
+    // When the last reference is dropped, Derived::on_last_release() is called if it exists (e.g. to hand the object
+    // back to an ObjectPool), otherwise the object is deleted.
+    template <typename Derived, typename Policy = atomic_count_policy>
+    class ref_counted {
+    private:
+        mutable typename Policy::count_type ref_count_ { 0 };
+
+    protected:
+        ref_counted() noexcept = default;
+        ~ref_counted() = default;
+
+        // copying an object must not copy its references
+        ref_counted(const ref_counted&) noexcept { }
+        ref_counted& operator=(const ref_counted&) noexcept { return *this; }
+
+    public:
+        unsigned long use_count() const noexcept { return Policy::load(ref_count_); }
+
+        friend void intrusive_ptr_add_ref(const Derived* obj) noexcept {
+            Policy::increment(static_cast<const ref_counted*>(obj)->ref_count_);
+        }
+
+        friend void intrusive_ptr_release(const Derived* obj) noexcept {
+            if (Policy::decrement(static_cast<const ref_counted*>(obj)->ref_count_)) {
+                Derived* self = const_cast<Derived*>(obj);
+                if constexpr (HasLastReleaseHook<Derived>) {
+                    self->on_last_release();
+                } else {
+                    delete self;
+                }
+            }
+        }
+    };
+
+    // Smart pointer to an object that carries its own reference count.
+    // The count is manipulated through intrusive_ptr_add_ref/intrusive_ptr_release found via ADL,
+    // which ref_counted provides, but any type can provide its own.
+    template <typename T>
+    class intrusive_ptr {
+    public:
+        using element_type = T;
+        using pointer = T*;
+
+    private:
+        pointer ptr_;
+
+        template <typename U>
+        friend class intrusive_ptr;
+
+    public:
+        constexpr intrusive_ptr() noexcept
+            : ptr_ { nullptr }
+        { }
+
+        constexpr intrusive_ptr(std::nullptr_t) noexcept
+            : ptr_ { nullptr }
+        { }
+
+        // add_ref = false adopts a reference that was previously detached with detach()
+        intrusive_ptr(pointer ptr, bool add_ref = true) noexcept
+            : ptr_ { ptr }
+        {
+            if (ptr_ && add_ref) {
+                intrusive_ptr_add_ref(ptr_);
+            }
+        }
+
+        intrusive_ptr(const intrusive_ptr& other) noexcept
+            : intrusive_ptr(other.ptr_)
+        { }
+
+        template <typename U>
+        requires std::convertible_to<U*, T*>
+        intrusive_ptr(const intrusive_ptr<U>& other) noexcept
+            : intrusive_ptr(other.ptr_)
+        { }
+
+        intrusive_ptr(intrusive_ptr&& other) noexcept
+            : ptr_ { std::exchange(other.ptr_, nullptr) }
+        { }
+
+        template <typename U>
+        requires std::convertible_to<U*, T*>
+        intrusive_ptr(intrusive_ptr<U>&& other) noexcept
+            : ptr_ { std::exchange(other.ptr_, nullptr) }
+        { }
+
+        ~intrusive_ptr() noexcept {
+            if (ptr_) {
+                intrusive_ptr_release(ptr_);
+            }
+        }
+
+        intrusive_ptr& operator=(const intrusive_ptr& other) noexcept {
+            intrusive_ptr(other).swap(*this);
+            return *this;
+        }
+
+        intrusive_ptr& operator=(intrusive_ptr&& other) noexcept {
+            intrusive_ptr(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        void reset() noexcept {
+            intrusive_ptr().swap(*this);
+        }
+
+        void reset(pointer ptr, bool add_ref = true) noexcept {
+            intrusive_ptr(ptr, add_ref).swap(*this);
+        }
+
+        // gives up ownership without decrementing the count
+        constexpr pointer detach() noexcept {
+            return std::exchange(ptr_, nullptr);
+        }
+
+        constexpr void swap(intrusive_ptr& other) noexcept {
+            std::swap(ptr_, other.ptr_);
+        }
+
+        constexpr pointer get() const noexcept { return ptr_; }
+
+        constexpr T& operator*() const noexcept { return *ptr_; }
+
+        constexpr pointer operator->() const noexcept { return ptr_; }
+
+        constexpr explicit operator bool() const noexcept { return ptr_; }
+    };
+
+    template <typename T, typename U>
+    constexpr bool operator==(const intrusive_ptr<T>& lhs, const intrusive_ptr<U>& rhs) noexcept {
+        return lhs.get() == rhs.get();
+    }
+
+    template <typename T>
+    constexpr bool operator==(const intrusive_ptr<T>& lhs, std::nullptr_t) noexcept {
+        return !lhs;
+    }
+
+    template <typename T, typename... Args>
+    intrusive_ptr<T> make_intrusive(Args&&... args) {
+        return intrusive_ptr<T>(new T(std::forward<Args>(args)...));
+    }
+}
+
+#endif
@@ -1,23 +1,35 @@
 #ifndef CUSTOM_STL_LOCK_GUARD_HPP
 #define CUSTOM_STL_LOCK_GUARD_HPP
 
-#include <mutex>
+#include <mutex> // For std::adopt_lock_t
+#include <source_location>
+
+#include "lockable.hpp"
+#include "lock_profiler.hpp"
 
 namespace CustomSTL {
-    template <typename mutex_t>
+    // site is only used when compiled with CUSTOMSTL_LOCK_PROFILING, see lock_profiler.hpp
+    template <BasicLockable mutex_t>
     class lock_guard {
     public:
-        explicit lock_guard(mutex_t& m)
+        explicit lock_guard(mutex_t& m, std::source_location site = std::source_location::current())
             : mutex_ { m }
+            , probe_ { site }
         {
+            probe_.waiting();
             mutex_.lock();
+            probe_.acquired();
         }
 
-        lock_guard(mutex_t& m, std::adopt_lock_t)
+        lock_guard(mutex_t& m, std::adopt_lock_t, std::source_location site = std::source_location::current())
             : mutex_ { m }
-        { }
+            , probe_ { site }
+        {
+            probe_.adopted();
+        }
 
         ~lock_guard() {
+            probe_.released();
             mutex_.unlock();
         }
         
@@ -26,7 +38,8 @@ namespace CustomSTL {
 
     private:
         mutex_t& mutex_;
+        [[no_unique_address]] lock_probe probe_;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
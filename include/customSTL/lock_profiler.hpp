@@ -0,0 +1,299 @@
+#ifndef CUSTOM_STL_LOCK_PROFILER_HPP
+#define CUSTOM_STL_LOCK_PROFILER_HPP
+
+#include <source_location>
+
+/*
+* Lock contention profiling for lock_guard/unique_lock/shared_lock, enabled by compiling with
+* -DCUSTOMSTL_LOCK_PROFILING (every translation unit of a program must agree, otherwise the guards violate the ODR).
+*
+* Each guard records, for the source location it was constructed at:
+*   - wait time: from the call to lock() until it returns
+*   - hold time: from acquisition until unlock()
+*   - failed try_lock attempts
+* Timestamps are raw TSC reads, and counters live in a table owned by the current thread, so recording never takes a
+* lock nor writes to a shared cache line. lock_profiling::snapshot() aggregates every thread's table per site and
+* lock_profiling::dump() prints it, sorted by total wait time.
+*
+* When profiling is disabled lock_probe is an empty class with inline no-op members, stored [[no_unique_address]] in
+* the guards, so they have the same size and code as without it.
+*/
+
+#ifdef CUSTOMSTL_LOCK_PROFILING
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace CustomSTL {
+namespace lock_profiling {
+
+    inline uint64_t timestamp() noexcept { return __rdtsc(); }
+
+    // Aggregated counters of one lock site, times are in TSC cycles
+    struct SiteStats {
+        std::string file;
+        uint32_t line = 0;
+        std::string function;
+        uint64_t acquisitions = 0;
+        uint64_t failed_attempts = 0;
+        uint64_t wait_cycles = 0;
+        uint64_t max_wait_cycles = 0;
+        uint64_t hold_cycles = 0;
+        uint64_t max_hold_cycles = 0;
+    };
+
+    namespace detail {
+        // Counters of one site, written only by the thread owning the table, so updates are plain load + store
+        // (no locked RMW) and concurrent readers see consistent per counter values.
+        struct SiteCounters {
+            std::atomic<const char*> file { nullptr }; // published last, a non null file means the entry is valid
+            uint32_t line = 0;
+            const char* function = nullptr;
+            std::atomic<uint64_t> acquisitions { 0 };
+            std::atomic<uint64_t> failed_attempts { 0 };
+            std::atomic<uint64_t> wait_cycles { 0 };
+            std::atomic<uint64_t> max_wait_cycles { 0 };
+            std::atomic<uint64_t> hold_cycles { 0 };
+            std::atomic<uint64_t> max_hold_cycles { 0 };
+        };
+
+        inline void add(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        inline void record_max(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+            if (value > counter.load(std::memory_order_relaxed)) {
+                counter.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        // Open addressing table of the sites used by one thread, keyed by the source_location file pointer and line
+        struct ThreadTable {
+            static constexpr size_t CAPACITY = 256;
+
+            SiteCounters sites[CAPACITY];
+            std::atomic<uint64_t> dropped { 0 }; // acquisitions not recorded because the table was full
+
+            SiteCounters* find(const std::source_location& site) noexcept {
+                size_t hash = std::hash<const void*>{}(site.file_name()) ^ (site.line() * 0x9E3779B97F4A7C15ull);
+                for (size_t i = 0; i < CAPACITY; ++i) {
+                    SiteCounters& entry = sites[(hash + i) % CAPACITY];
+                    const char* file = entry.file.load(std::memory_order_relaxed);
+                    if (file == nullptr) {
+                        entry.line = site.line();
+                        entry.function = site.function_name();
+                        entry.file.store(site.file_name(), std::memory_order_release);
+                        return &entry;
+                    }
+                    if (file == site.file_name() && entry.line == site.line()) {
+                        return &entry;
+                    }
+                }
+                add(dropped, 1);
+                return nullptr;
+            }
+        };
+
+        using SiteKey = std::tuple<std::string, uint32_t>;
+
+        inline void merge(std::map<SiteKey, SiteStats>& stats, const ThreadTable& table) {
+            for (const SiteCounters& entry : table.sites) {
+                const char* file = entry.file.load(std::memory_order_acquire);
+                if (file == nullptr) {
+                    continue;
+                }
+
+                // the same file can have several file_name() pointers (one per translation unit), so merge by name
+                SiteStats& site = stats[SiteKey { file, entry.line }];
+                site.file = file;
+                site.line = entry.line;
+                site.function = entry.function;
+                site.acquisitions += entry.acquisitions.load(std::memory_order_relaxed);
+                site.failed_attempts += entry.failed_attempts.load(std::memory_order_relaxed);
+                site.wait_cycles += entry.wait_cycles.load(std::memory_order_relaxed);
+                site.max_wait_cycles = std::max(site.max_wait_cycles, entry.max_wait_cycles.load(std::memory_order_relaxed));
+                site.hold_cycles += entry.hold_cycles.load(std::memory_order_relaxed);
+                site.max_hold_cycles = std::max(site.max_hold_cycles, entry.max_hold_cycles.load(std::memory_order_relaxed));
+            }
+        }
+
+        // Every live thread table, plus the merged counters of the threads that already exited
+        struct Registry {
+            std::mutex mutex;
+            std::vector<ThreadTable*> tables;
+            std::map<SiteKey, SiteStats> exited;
+        };
+
+        // never destroyed, so that threads exiting during static destruction can still unregister
+        inline Registry& registry() {
+            static Registry* instance = new Registry();
+            return *instance;
+        }
+
+        class ThreadTableOwner {
+        public:
+            ThreadTableOwner()
+                : table_ { new ThreadTable() }
+            {
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                r.tables.push_back(table_);
+            }
+
+            ~ThreadTableOwner() {
+                Registry& r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                merge(r.exited, *table_);
+                std::erase(r.tables, table_);
+                delete table_;
+            }
+
+            ThreadTableOwner(const ThreadTableOwner&) = delete;
+            ThreadTableOwner& operator=(const ThreadTableOwner&) = delete;
+
+            ThreadTable& table() noexcept { return *table_; }
+
+        private:
+            ThreadTable* table_;
+        };
+
+        inline ThreadTable& this_thread_table() {
+            thread_local ThreadTableOwner owner;
+            return owner.table();
+        }
+    } // namespace detail
+
+    // Aggregated counters of every site, across all threads (live and exited), sorted by total wait time
+    inline std::vector<SiteStats> snapshot() {
+        std::map<detail::SiteKey, SiteStats> merged;
+        {
+            detail::Registry& r = detail::registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            merged = r.exited;
+            for (const detail::ThreadTable* table : r.tables) {
+                detail::merge(merged, *table);
+            }
+        }
+
+        std::vector<SiteStats> stats;
+        stats.reserve(merged.size());
+        for (auto& [key, site] : merged) {
+            stats.push_back(std::move(site));
+        }
+        std::sort(stats.begin(), stats.end(), [](const SiteStats& a, const SiteStats& b) { return a.wait_cycles > b.wait_cycles; });
+        return stats;
+    }
+
+    // TSC frequency, measured once against steady_clock over ~10ms
+    inline double cycles_per_ns() {
+        static const double value = [] {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t start_cycles = timestamp();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            uint64_t cycles = timestamp() - start_cycles;
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            return static_cast<double>(cycles) / static_cast<double>(ns);
+        }();
+        return value;
+    }
+
+    // One line per site: location, acquisitions, failed try_locks, then total/mean/max wait and hold in microseconds
+    inline void dump(std::ostream& out) {
+        const double cycles_per_us = cycles_per_ns() * 1000.0;
+        auto us = [cycles_per_us](double cycles) { return cycles / cycles_per_us; };
+
+        out << "site acquisitions failed wait_total_us wait_mean_us wait_max_us hold_total_us hold_mean_us hold_max_us\n";
+        for (const SiteStats& site : snapshot()) {
+            double count = static_cast<double>(std::max<uint64_t>(site.acquisitions, 1));
+            out << site.file << ':' << site.line << " (" << site.function << ") "
+                << site.acquisitions << ' ' << site.failed_attempts << ' '
+                << us(site.wait_cycles) << ' ' << us(site.wait_cycles / count) << ' ' << us(site.max_wait_cycles) << ' '
+                << us(site.hold_cycles) << ' ' << us(site.hold_cycles / count) << ' ' << us(site.max_hold_cycles) << '\n';
+        }
+    }
+
+} // namespace lock_profiling
+
+// Timing state of one guard: call waiting() before locking, then acquired() or failed(), and released() on unlock
+class lock_probe {
+public:
+    explicit lock_probe(const std::source_location& site) noexcept
+        : site_ { site }
+    { }
+
+    void waiting() noexcept { wait_start_ = lock_profiling::timestamp(); }
+
+    void acquired() noexcept {
+        acquired_at_ = lock_profiling::timestamp();
+        if (lock_profiling::detail::SiteCounters* counters = counters_for_site()) {
+            uint64_t wait = acquired_at_ - wait_start_;
+            lock_profiling::detail::add(counters->acquisitions, 1);
+            lock_profiling::detail::add(counters->wait_cycles, wait);
+            lock_profiling::detail::record_max(counters->max_wait_cycles, wait);
+        }
+    }
+
+    // the lock was adopted, only the hold time is known
+    void adopted() noexcept {
+        wait_start_ = lock_profiling::timestamp();
+        acquired();
+    }
+
+    void failed() noexcept {
+        if (lock_profiling::detail::SiteCounters* counters = counters_for_site()) {
+            lock_profiling::detail::add(counters->failed_attempts, 1);
+        }
+    }
+
+    void released() noexcept {
+        // a moved unique_lock may be unlocked on another thread, its hold time goes to that thread's table
+        if (lock_profiling::detail::SiteCounters* counters = counters_for_site()) {
+            uint64_t hold = lock_profiling::timestamp() - acquired_at_;
+            lock_profiling::detail::add(counters->hold_cycles, hold);
+            lock_profiling::detail::record_max(counters->max_hold_cycles, hold);
+        }
+    }
+
+private:
+    lock_profiling::detail::SiteCounters* counters_for_site() noexcept {
+        return lock_profiling::detail::this_thread_table().find(site_);
+    }
+
+    std::source_location site_;
+    uint64_t wait_start_ = 0;
+    uint64_t acquired_at_ = 0;
+};
+
+} // namespace CustomSTL
+
+#else
+
+namespace CustomSTL {
+
+class lock_probe {
+public:
+    constexpr explicit lock_probe(const std::source_location&) noexcept { }
+
+    constexpr void waiting() noexcept { }
+    constexpr void acquired() noexcept { }
+    constexpr void adopted() noexcept { }
+    constexpr void failed() noexcept { }
+    constexpr void released() noexcept { }
+};
+
+} // namespace CustomSTL
+
+#endif
+
+#endif
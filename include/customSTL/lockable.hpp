@@ -0,0 +1,46 @@
+#ifndef CUSTOM_STL_LOCKABLE_HPP
+#define CUSTOM_STL_LOCKABLE_HPP
+
+#include <chrono>
+#include <concepts>
+
+namespace CustomSTL {
+    // Named requirements of the standard library (BasicLockable, Lockable, TimedLockable) expressed as concepts,
+    // used by lock_guard/unique_lock/shared_lock and satisfied by every lock in this library.
+    template <typename M>
+    concept BasicLockable = requires(M& m) {
+        m.lock();
+        m.unlock();
+    };
+
+    template <typename M>
+    concept Lockable = BasicLockable<M> && requires(M& m) {
+        { m.try_lock() } -> std::convertible_to<bool>;
+    };
+
+    template <typename M>
+    concept TimedLockable = Lockable<M> && requires(M& m,
+                                                    const std::chrono::milliseconds& timeout_duration,
+                                                    const std::chrono::steady_clock::time_point& timeout_time) {
+        { m.try_lock_for(timeout_duration) } -> std::convertible_to<bool>;
+        { m.try_lock_until(timeout_time) } -> std::convertible_to<bool>;
+    };
+
+    // SharedLockable/SharedTimedLockable, the shared side of a reader-writer lock, used by shared_lock
+    template <typename M>
+    concept SharedLockable = requires(M& m) {
+        m.lock_shared();
+        m.unlock_shared();
+        { m.try_lock_shared() } -> std::convertible_to<bool>;
+    };
+
+    template <typename M>
+    concept SharedTimedLockable = SharedLockable<M> && requires(M& m,
+                                                                const std::chrono::milliseconds& timeout_duration,
+                                                                const std::chrono::steady_clock::time_point& timeout_time) {
+        { m.try_lock_shared_for(timeout_duration) } -> std::convertible_to<bool>;
+        { m.try_lock_shared_until(timeout_time) } -> std::convertible_to<bool>;
+    };
+}
+
+#endif
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+namespace CustomSTL {
+
+/*
+* mapped_vector is a vector whose storage lives in a file that is mapped into memory.
+* Elements are never serialized: the bytes in the file are the bytes in memory,
+* so reopening a table is an mmap instead of a parse.
+* Only trivially copyable types are supported since the file may outlive the process
+* and we never run constructors/destructors on the mapped elements.
+*
+* File layout: [ Header (64 bytes) | T[0] | T[1] | ... | T[capacity - 1] ]
+*/
+template <typename T>
+class mapped_vector {
+    static_assert(std::is_trivially_copyable_v<T>, "Type must be trivially copyable");
+    static_assert(alignof(T) <= 64, "Type alignment must not exceed the header alignment");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    // bump whenever the header layout changes so that stale files are rejected
+    static constexpr uint32_t VERSION = 1;
+
+    enum class Paging {
+        Lazy,       // pages are faulted in on first access
+        Populate    // MAP_POPULATE, prefault the whole file during open
+    };
+
+    // Opens (or creates) the file at path for reading and writing
+    explicit mapped_vector(const std::string& path, size_t initial_capacity = 0)
+        : read_only_ { false } {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ == -1) {
+            throw std::runtime_error("Unable to open file: " + path);
+        }
+
+        try {
+            size_t file_size = current_file_size();
+            if (file_size == 0) {
+                // new file, write a fresh header
+                size_t capacity = initial_capacity == 0 ? 1 : initial_capacity;
+                truncate_to(bytes_for(capacity));
+                map(bytes_for(capacity), PROT_READ | PROT_WRITE, 0);
+
+                Header* header = this->header();
+                header->magic = MAGIC;
+                header->version = VERSION;
+                header->element_size = sizeof(T);
+                header->size = 0;
+                header->capacity = capacity;
+            } else {
+                map(file_size, PROT_READ | PROT_WRITE, 0);
+                validate(file_size);
+
+                if (initial_capacity > capacity()) {
+                    reserve(initial_capacity);
+                }
+            }
+        } catch (...) {
+            release_resources();
+            throw;
+        }
+    }
+
+    // Opens an existing file read only. The elements are used in place (zero copy).
+    static mapped_vector open_read_only(const std::string& path, Paging paging = Paging::Lazy) {
+        return mapped_vector(path, paging);
+    }
+
+    ~mapped_vector() {
+        release_resources();
+    }
+
+    // disable copy semantics, the mapping is owned by exactly one object
+    mapped_vector(const mapped_vector&) = delete;
+    mapped_vector& operator=(const mapped_vector&) = delete;
+
+    mapped_vector(mapped_vector&& other) noexcept
+        : fd_ { std::exchange(other.fd_, -1) }
+        , base_ { std::exchange(other.base_, nullptr) }
+        , mapped_bytes_ { std::exchange(other.mapped_bytes_, 0) }
+        , read_only_ { other.read_only_ }
+    { }
+
+    mapped_vector& operator=(mapped_vector&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+
+        release_resources();
+
+        fd_ = std::exchange(other.fd_, -1);
+        base_ = std::exchange(other.base_, nullptr);
+        mapped_bytes_ = std::exchange(other.mapped_bytes_, 0);
+        read_only_ = other.read_only_;
+
+        return *this;
+    }
+
+    void push_back(const T& value) {
+        ensure_writable();
+
+        // value may be one of our elements (v.push_back(v[0])), and growing can move or unmap the old mapping
+        T copy = value;
+        Header* header = this->header();
+        if (header->size == header->capacity) {
+            reserve(header->capacity << 1); // exponential increment, same as vector
+            header = this->header();
+        }
+
+        data()[header->size] = copy;
+        ++header->size;
+    }
+
+    void pop_back() {
+        ensure_writable();
+
+        if (empty()) [[unlikely]] {
+            throw std::logic_error("mapped_vector is empty");
+        }
+
+        --header()->size;
+    }
+
+    void clear() {
+        ensure_writable();
+        header()->size = 0;
+    }
+
+    // Grows the backing file with ftruncate and remaps it
+    void reserve(size_t new_capacity) {
+        ensure_writable();
+
+        if (new_capacity <= capacity()) {
+            return;
+        }
+
+        size_t new_bytes = bytes_for(new_capacity);
+        truncate_to(new_bytes);
+
+        void* addr = ::mremap(base_, mapped_bytes_, new_bytes, MREMAP_MAYMOVE);
+        if (addr == MAP_FAILED) [[unlikely]] {
+            throw std::runtime_error("Unable to remap file");
+        }
+
+        base_ = static_cast<char*>(addr);
+        mapped_bytes_ = new_bytes;
+        header()->capacity = new_capacity;
+    }
+
+    // Writes dirty pages back to the file. When async is set, the write back is only scheduled.
+    void flush(bool async = false) {
+        if (read_only_ || base_ == nullptr) {
+            return;
+        }
+
+        if (::msync(base_, mapped_bytes_, async ? MS_ASYNC : MS_SYNC) == -1) {
+            throw std::runtime_error("Unable to flush mapped file");
+        }
+    }
+
+    T& operator[](size_t index) noexcept { return data()[index]; }
+    const T& operator[](size_t index) const noexcept { return data()[index]; }
+
+    T* data() noexcept { return reinterpret_cast<T*>(base_ + sizeof(Header)); }
+    const T* data() const noexcept { return reinterpret_cast<const T*>(base_ + sizeof(Header)); }
+
+    iterator begin() noexcept { return data(); }
+    iterator end() noexcept { return data() + size(); }
+    const_iterator begin() const noexcept { return data(); }
+    const_iterator end() const noexcept { return data() + size(); }
+
+    // a moved from mapped_vector has no mapping, and is empty
+    size_t size() const noexcept { return base_ == nullptr ? 0 : header()->size; }
+    size_t capacity() const noexcept { return base_ == nullptr ? 0 : header()->capacity; }
+    bool empty() const noexcept { return size() == 0; }
+    bool read_only() const noexcept { return read_only_; }
+
+private:
+    struct alignas(64) Header {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t element_size;
+        uint64_t size;
+        uint64_t capacity;
+    };
+
+    static_assert(sizeof(Header) == 64, "Header must occupy exactly one cache line");
+
+    static constexpr uint64_t MAGIC = 0x524F54434556504DULL; // "MPVECTOR"
+
+    mapped_vector(const std::string& path, Paging paging)
+        : read_only_ { true } {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ == -1) {
+            throw std::runtime_error("Unable to open file: " + path);
+        }
+
+        try {
+            size_t file_size = current_file_size();
+            if (file_size < sizeof(Header)) {
+                throw std::runtime_error("File is too small to be a mapped_vector: " + path);
+            }
+
+            map(file_size, PROT_READ, paging == Paging::Populate ? MAP_POPULATE : 0);
+            validate(file_size);
+        } catch (...) {
+            release_resources();
+            throw;
+        }
+    }
+
+    static constexpr size_t bytes_for(size_t capacity) noexcept {
+        return sizeof(Header) + capacity * sizeof(T);
+    }
+
+    Header* header() noexcept { return reinterpret_cast<Header*>(base_); }
+    const Header* header() const noexcept { return reinterpret_cast<const Header*>(base_); }
+
+    size_t current_file_size() {
+        struct stat file_info;
+        if (::fstat(fd_, &file_info) == -1) {
+            throw std::runtime_error("Unable to stat file");
+        }
+        return static_cast<size_t>(file_info.st_size);
+    }
+
+    void truncate_to(size_t bytes) {
+        if (::ftruncate(fd_, static_cast<off_t>(bytes)) == -1) {
+            throw std::runtime_error("Unable to resize file");
+        }
+    }
+
+    void map(size_t bytes, int protection, int extra_flags) {
+        void* addr = ::mmap(nullptr, bytes, protection, MAP_SHARED | extra_flags, fd_, 0);
+        if (addr == MAP_FAILED) [[unlikely]] {
+            throw std::runtime_error("Unable to mmap file");
+        }
+
+        base_ = static_cast<char*>(addr);
+        mapped_bytes_ = bytes;
+    }
+
+    void unmap() noexcept {
+        if (base_ != nullptr) {
+            ::munmap(base_, mapped_bytes_);
+            base_ = nullptr;
+            mapped_bytes_ = 0;
+        }
+    }
+
+    void release_resources() noexcept {
+        unmap();
+        if (fd_ != -1) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // Rejects files written by another layout / element type, or files that were truncated
+    void validate(size_t file_size) {
+        const Header* header = this->header();
+        const char* error = nullptr;
+
+        if (header->magic != MAGIC) {
+            error = "File is not a mapped_vector";
+        } else if (header->version != VERSION) {
+            error = "mapped_vector version mismatch";
+        } else if (header->element_size != sizeof(T)) {
+            error = "mapped_vector element size mismatch";
+        } else if (header->size > header->capacity || bytes_for(header->capacity) > file_size) {
+            error = "mapped_vector file is truncated";
+        }
+
+        if (error != nullptr) {
+            throw std::runtime_error(error);
+        }
+    }
+
+    void ensure_writable() const {
+        if (read_only_) [[unlikely]] {
+            throw std::logic_error("mapped_vector is read only");
+        }
+    }
+
+    int fd_ = -1;
+    char* base_ = nullptr;
+    size_t mapped_bytes_ = 0;
+    bool read_only_;
+};
+
+} // namespace CustomSTL
@@ -1,74 +1,210 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdlib>
 #include <new>
 #include <utility>
 #include <cstddef>
 #include <type_traits>
 
+#include "unique_ptr.hpp"
+
 namespace CustomSTL {
 
-template <typename T>
-class ObjectPool {
+// Free list of fixed size slots carved out of a single allocation.
+// This is kept separate from ObjectPool<T> so that allocators (see pool_allocator) can
+// hand out slots without needing to know the T that the pool was created for.
+class SlotPool {
 private:
     union Node {
         Node* next;
-    }
-
-    Node* head_;   // points to free list
-    Node* end_; // points one past end of storage
+    };
 
+    Node* storage_; // start of the underlying allocation, used to free it
+    Node* head_;    // points to free list
+    size_t slot_size_;
+    size_t slot_alignment_;
+    size_t capacity_;
 
 public:
-    ObjectPool(size_t capacity) {
-        size_t object_size = std::max(sizeof(T), sizeof(Node*)); // if T is too small, we add padding so that it can fit a pointer
-
-        size_t bytes_needed = capacity * object_size;
-        size_t aligned_bytes_needed = (bytes_needed + alignof(T) - 1) & ~(alignof(T) - 1);
-
-        head_ = static_cast<Node *>(std::aligned_alloc(alignof(T), aligned_bytes_needed));
-        if (head_ == nullptr) {
-            throw std::bad_alloc;
+    SlotPool(size_t slot_size, size_t slot_alignment, size_t capacity)
+        : slot_alignment_ { std::max(slot_alignment, alignof(Node)) }
+        , capacity_ { capacity } {
+        // if the slot is too small, we add padding so that it can fit a pointer
+        // the slot size is also rounded up to the alignment so that every slot stays aligned
+        slot_size_ = std::max(slot_size, sizeof(Node));
+        slot_size_ = (slot_size_ + slot_alignment_ - 1) & ~(slot_alignment_ - 1);
+
+        size_t bytes_needed = std::max(capacity, size_t { 1 }) * slot_size_;
+
+        storage_ = static_cast<Node *>(std::aligned_alloc(slot_alignment_, bytes_needed));
+        if (storage_ == nullptr) {
+            throw std::bad_alloc();
         }
 
         // construct the free list
-        Node* curr = head_;
+        Node* curr = storage_;
         for (size_t i = 1; i < capacity; ++i) {
-            curr->next = reinterpret_cast<Node *>(static_cast<char *>(curr) + object_size);
+            curr->next = reinterpret_cast<Node *>(reinterpret_cast<char *>(curr) + slot_size_);
             curr = curr->next;
         }
 
         curr->next = nullptr;
+        head_ = capacity == 0 ? nullptr : storage_;
     }
 
     // User needs to enforce that they release all objects before object pool is destructed
     // else there is a potential memory leak
-    ~ObjectPool() {
-        std::free(head_);
+    ~SlotPool() {
+        std::free(storage_);
     }
 
-    template <typename... Args>
-    T* acquire(Args&&... args) {
+    // copying is prohibited as we are managing raw memory
+    SlotPool(const SlotPool&) = delete;
+    SlotPool& operator=(const SlotPool&) = delete;
+
+    // returns uninitialized memory for a single slot, or nullptr if the pool is exhausted
+    void* allocate() noexcept {
         if (head_ == nullptr) {
             return nullptr;
         }
 
-        Node* next_head = head_->next;
-        T* obj = reinterpret_cast<T*>(head_);
-        new (obj) T(std::forward<Args>(args)...);
+        Node* slot = head_;
+        head_ = head_->next;
+        return slot;
+    }
+
+    void deallocate(void* slot) noexcept {
+        Node* new_head = static_cast<Node*>(slot);
+        new_head->next = head_;
+        head_ = new_head;
+    }
+
+    size_t slot_size() const noexcept { return slot_size_; }
+    size_t slot_alignment() const noexcept { return slot_alignment_; }
+    size_t capacity() const noexcept { return capacity_; }
 
-        head_ = next_head;
-        return obj;
+    // whether ptr points into one of this pool's slots
+    bool owns(const void* ptr) const noexcept {
+        const char* begin = reinterpret_cast<const char*>(storage_);
+        const char* p = static_cast<const char*>(ptr);
+        return p >= begin && p < begin + capacity_ * slot_size_;
+    }
+
+    const void* storage() const noexcept { return storage_; }
+};
+
+template <typename T>
+class ObjectPool : public SlotPool {
+public:
+    explicit ObjectPool(size_t capacity)
+        : SlotPool(sizeof(T), alignof(T), capacity)
+    { }
+
+    template <typename... Args>
+    T* acquire(Args&&... args) {
+        void* slot = allocate();
+        if (slot == nullptr) {
+            return nullptr;
+        }
+
+        if constexpr (std::is_nothrow_constructible_v<T, Args...>) {
+            return new (slot) T(std::forward<Args>(args)...);
+        } else {
+            try {
+                return new (slot) T(std::forward<Args>(args)...);
+            } catch (...) {
+                deallocate(slot);
+                throw;
+            }
+        }
     }
 
     void release(T* ptr) {
         ptr->~T();
-        
-        Node* new_head = reinterpret_cast<Node*>(ptr);
-        new_head->next = head_;
-        head_ = new_head;
+        deallocate(ptr);
     }
+};
+
+// Allocator adapter so that containers/smart pointers (e.g. allocate_shared) can take their memory from a pool.
+// Only single object allocations are supported, and the rebound type must fit inside one of the pool's slots.
+template <typename T>
+class pool_allocator {
+public:
+    using value_type = T;
+
+    explicit pool_allocator(SlotPool& pool) noexcept
+        : pool_ { &pool }
+    { }
+
+    template <typename U>
+    pool_allocator(const pool_allocator<U>& other) noexcept
+        : pool_ { other.pool() }
+    { }
+
+    T* allocate(size_t n) {
+        if (n != 1 || sizeof(T) > pool_->slot_size() || alignof(T) > pool_->slot_alignment()) [[unlikely]] {
+            throw std::bad_alloc();
+        }
 
+        void* slot = pool_->allocate();
+        if (slot == nullptr) [[unlikely]] {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(slot);
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        pool_->deallocate(ptr);
+    }
+
+    SlotPool* pool() const noexcept { return pool_; }
+
+    template <typename U>
+    bool operator==(const pool_allocator<U>& other) const noexcept { return pool_ == other.pool(); }
+
+private:
+    SlotPool* pool_;
 };
 
-}
\ No newline at end of file
+// Deleter handing objects back to the pool they were acquired from.
+// Holds a pointer to the pool, so unique_ptr<T, pool_deleter<T>> is two pointers wide.
+template <typename T>
+class pool_deleter {
+public:
+    pool_deleter() noexcept = default;
+
+    explicit pool_deleter(ObjectPool<T>& pool) noexcept
+        : pool_ { &pool }
+    { }
+
+    void operator()(T* ptr) const noexcept { pool_->release(ptr); }
+
+    ObjectPool<T>* pool() const noexcept { return pool_; }
+
+private:
+    ObjectPool<T>* pool_ = nullptr;
+};
+
+// Stateless deleter for a pool with static storage duration, the pool is part of the type.
+// unique_ptr<T, static_pool_deleter<T, Pool>> is the size of a raw pointer.
+template <typename T, ObjectPool<T>& Pool>
+struct static_pool_deleter {
+    void operator()(T* ptr) const noexcept { Pool.release(ptr); }
+};
+
+template <typename T>
+using pool_unique_ptr = unique_ptr<T, pool_deleter<T>>;
+
+// Returns an empty unique_ptr if the pool is exhausted, like ObjectPool::acquire
+template <typename T, typename... Args>
+pool_unique_ptr<T> make_unique_from(ObjectPool<T>& pool, Args&&... args) {
+    return pool_unique_ptr<T>(pool.acquire(std::forward<Args>(args)...), pool_deleter<T>(pool));
+}
+
+template <typename T, ObjectPool<T>& Pool, typename... Args>
+unique_ptr<T, static_pool_deleter<T, Pool>> make_unique_from(Args&&... args) {
+    return unique_ptr<T, static_pool_deleter<T, Pool>>(Pool.acquire(std::forward<Args>(args)...));
+}
+
+}
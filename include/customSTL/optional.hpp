@@ -1,33 +1,365 @@
 #ifndef CUSTOM_STL_OPTIONAL_HPP
 #define CUSTOM_STL_OPTIONAL_HPP
 
-#include <optional>
+#include <concepts>
+#include <limits>
+#include <memory> // For std::construct_at & std::destroy_at
+#include <optional> // For std::nullopt_t & std::bad_optional_access
+#include <type_traits>
+#include <utility>
 
 namespace CustomSTL {
 
+// The value is stored in a union, so that it is only constructed while the optional holds a value.
+// Copy/move/destruction are trivial whenever they are for T, so optional<T> stays trivially copyable for trivial T.
 template <typename T>
 class optional {
+    static_assert(!std::is_reference_v<T>, "optional of a reference is not supported");
+
 public:
     using value_type = T;
 
     constexpr optional() noexcept
-        : val_ { nullptr }
+        : empty_ {}
         , is_valid_ { false }
     { }
 
-    constexpr optional(std::nullopt_t)
+    constexpr optional(std::nullopt_t) noexcept
         : optional()
     { }
 
-    constexpr optional(const optional& other)
-        : val_ {}
+    template <typename... Args>
+    constexpr explicit optional(std::in_place_t, Args&&... args)
+        : val_ (std::forward<Args>(args)...)
+        , is_valid_ { true }
+    { }
+
+    template <typename U = T>
+    requires std::constructible_from<T, U&&> &&
+             (!std::same_as<std::remove_cvref_t<U>, optional>) &&
+             (!std::same_as<std::remove_cvref_t<U>, std::in_place_t>) &&
+             (!std::same_as<std::remove_cvref_t<U>, std::nullopt_t>)
+    constexpr explicit(!std::convertible_to<U&&, T>) optional(U&& value)
+        : val_ (std::forward<U>(value))
+        , is_valid_ { true }
+    { }
+
+    constexpr optional(const optional& other) requires std::is_trivially_copy_constructible_v<T> = default;
+
+    constexpr optional(const optional& other) noexcept(std::is_nothrow_copy_constructible_v<T>)
+        requires std::is_copy_constructible_v<T> && (!std::is_trivially_copy_constructible_v<T>)
+        : optional(from_other, other)
+    { }
+
+    constexpr optional(optional&& other) requires std::is_trivially_move_constructible_v<T> = default;
+
+    constexpr optional(optional&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        requires std::is_move_constructible_v<T> && (!std::is_trivially_move_constructible_v<T>)
+        : optional(from_other, std::move(other))
+    { }
+
+    constexpr ~optional() requires std::is_trivially_destructible_v<T> = default;
+
+    constexpr ~optional() requires (!std::is_trivially_destructible_v<T>) {
+        reset();
+    }
+
+    constexpr optional& operator=(const optional& other)
+        requires std::is_trivially_copy_assignable_v<T> && std::is_trivially_copy_constructible_v<T> &&
+                 std::is_trivially_destructible_v<T>
+        = default;
+
+    constexpr optional& operator=(const optional& other)
+        requires std::is_copy_constructible_v<T> && std::is_copy_assignable_v<T> &&
+                 (!(std::is_trivially_copy_assignable_v<T> && std::is_trivially_copy_constructible_v<T> &&
+                    std::is_trivially_destructible_v<T>))
+    {
+        assign(other);
+        return *this;
+    }
+
+    constexpr optional& operator=(optional&& other)
+        requires std::is_trivially_move_assignable_v<T> && std::is_trivially_move_constructible_v<T> &&
+                 std::is_trivially_destructible_v<T>
+        = default;
+
+    constexpr optional& operator=(optional&& other)
+        noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>)
+        requires std::is_move_constructible_v<T> && std::is_move_assignable_v<T> &&
+                 (!(std::is_trivially_move_assignable_v<T> && std::is_trivially_move_constructible_v<T> &&
+                    std::is_trivially_destructible_v<T>))
+    {
+        assign(std::move(other));
+        return *this;
+    }
+
+    constexpr optional& operator=(std::nullopt_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    template <typename U = T>
+    requires std::constructible_from<T, U&&> && std::assignable_from<T&, U&&> &&
+             (!std::same_as<std::remove_cvref_t<U>, optional>) &&
+             (!std::same_as<std::remove_cvref_t<U>, std::nullopt_t>)
+    constexpr optional& operator=(U&& value) {
+        if (is_valid_) {
+            val_ = std::forward<U>(value);
+        } else {
+            emplace(std::forward<U>(value));
+        }
+        return *this;
+    }
+
+    template <typename... Args>
+    constexpr T& emplace(Args&&... args) {
+        reset();
+        std::construct_at(&val_, std::forward<Args>(args)...);
+        is_valid_ = true;
+        return val_;
+    }
+
+    constexpr void reset() noexcept {
+        if (is_valid_) {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                std::destroy_at(&val_);
+            }
+            is_valid_ = false;
+        }
+    }
+
+    constexpr void swap(optional& other) noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_swappable_v<T>) {
+        if (is_valid_ && other.is_valid_) {
+            using std::swap;
+            swap(val_, other.val_);
+        } else if (is_valid_) {
+            other.emplace(std::move(val_));
+            reset();
+        } else if (other.is_valid_) {
+            emplace(std::move(other.val_));
+            other.reset();
+        }
+    }
+
+    constexpr bool has_value() const noexcept { return is_valid_; }
+
+    constexpr explicit operator bool() const noexcept { return is_valid_; }
+
+    constexpr T& value() & {
+        if (!is_valid_) {
+            throw std::bad_optional_access();
+        }
+        return val_;
+    }
+
+    constexpr const T& value() const & {
+        if (!is_valid_) {
+            throw std::bad_optional_access();
+        }
+        return val_;
+    }
+
+    constexpr T&& value() && {
+        if (!is_valid_) {
+            throw std::bad_optional_access();
+        }
+        return std::move(val_);
+    }
+
+    template <typename U>
+    constexpr T value_or(U&& default_value) const & {
+        return is_valid_ ? val_ : static_cast<T>(std::forward<U>(default_value));
+    }
+
+    template <typename U>
+    constexpr T value_or(U&& default_value) && {
+        return is_valid_ ? std::move(val_) : static_cast<T>(std::forward<U>(default_value));
+    }
+
+    // unchecked access, like std::optional
+    constexpr T& operator*() & noexcept { return val_; }
+
+    constexpr const T& operator*() const & noexcept { return val_; }
+
+    constexpr T&& operator*() && noexcept { return std::move(val_); }
+
+    constexpr T* operator->() noexcept { return &val_; }
+
+    constexpr const T* operator->() const noexcept { return &val_; }
 
 private:
-    value_type val_;
+    template <typename Other>
+    constexpr void assign(Other&& other) {
+        if (other.is_valid_) {
+            if (is_valid_) {
+                val_ = std::forward<Other>(other).val_;
+            } else {
+                emplace(std::forward<Other>(other).val_);
+            }
+        } else {
+            reset();
+        }
+    }
+
+    struct Empty { };
+
+    struct FromOther { };
+    static constexpr FromOther from_other {};
+
+    // Copies or moves the value of another optional straight into the union, with the flag set in the same
+    // constructor, instead of starting empty and going through emplace() (which resets first)
+    template <typename Other>
+    constexpr optional(FromOther, Other&& other)
+        : empty_ {}
+        , is_valid_ { other.is_valid_ }
+    {
+        if (is_valid_) {
+            std::construct_at(&val_, std::forward<Other>(other).val_);
+        }
+    }
+
+    union {
+        Empty empty_;
+        value_type val_;
+    };
     bool is_valid_;
+};
+
+template <typename T>
+constexpr bool operator==(const optional<T>& lhs, const optional<T>& rhs) {
+    if (lhs.has_value() != rhs.has_value()) {
+        return false;
+    }
+    return !lhs.has_value() || *lhs == *rhs;
+}
+
+template <typename T>
+constexpr bool operator==(const optional<T>& opt, std::nullopt_t) noexcept { return !opt.has_value(); }
 
+template <typename T, typename U>
+requires (!std::same_as<U, std::nullopt_t>)
+constexpr bool operator==(const optional<T>& opt, const U& value) { return opt.has_value() && *opt == value; }
+
+template <typename T>
+constexpr optional<std::decay_t<T>> make_optional(T&& value) {
+    return optional<std::decay_t<T>>(std::forward<T>(value));
+}
+
+/*
+* Sentinel traits for compact_optional, encoding "empty" in a value that T never takes when it is engaged.
+* A Traits type provides:
+*   static constexpr T empty_value() noexcept;          the bit pattern stored while empty
+*   static constexpr bool is_empty(const T&) noexcept;  whether a stored value is the sentinel
+*/
+template <typename T>
+struct nan_sentinel {
+    static_assert(std::numeric_limits<T>::has_quiet_NaN);
+
+    static constexpr T empty_value() noexcept { return std::numeric_limits<T>::quiet_NaN(); }
+    // NaN != NaN, so x != x is the constexpr friendly std::isnan
+    static constexpr bool is_empty(const T& value) noexcept { return value != value; }
+};
+
+template <typename T, T Sentinel>
+struct value_sentinel {
+    static constexpr T empty_value() noexcept { return Sentinel; }
+    static constexpr bool is_empty(const T& value) noexcept { return value == Sentinel; }
+};
+
+// the lowest value for signed integers (e.g. INT_MIN), the highest one for unsigned integers
+template <std::integral T>
+using integral_sentinel = value_sentinel<T, std::is_signed_v<T> ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max()>;
+
+template <typename T>
+struct null_sentinel {
+    static constexpr T empty_value() noexcept { return nullptr; }
+    static constexpr bool is_empty(const T& value) noexcept { return value == nullptr; }
+};
+
+template <typename T>
+struct default_sentinel;
+
+template <std::floating_point T>
+struct default_sentinel<T> : nan_sentinel<T> { };
+
+template <std::integral T>
+requires (!std::same_as<T, bool>)
+struct default_sentinel<T> : integral_sentinel<T> { };
+
+template <typename T>
+requires std::is_pointer_v<T>
+struct default_sentinel<T> : null_sentinel<T> { };
+
+/*
+* optional without the bool: "empty" is stored as a sentinel value of T chosen by Traits (NaN for prices, INT_MIN
+* for quantities, nullptr for pointers), so sizeof(compact_optional<T>) == sizeof(T) and arrays of them stay dense.
+* The sentinel itself can never be stored as a value, assigning it makes the optional empty.
+*/
+template <typename T, typename Traits = default_sentinel<T>>
+class compact_optional {
+    static_assert(std::is_trivially_copyable_v<T>, "compact_optional is meant for small trivially copyable values");
+
+public:
+    using value_type = T;
+    using traits_type = Traits;
+
+    constexpr compact_optional() noexcept
+        : val_ { Traits::empty_value() }
+    { }
+
+    constexpr compact_optional(std::nullopt_t) noexcept
+        : compact_optional()
+    { }
+
+    constexpr compact_optional(const T& value) noexcept
+        : val_ { value }
+    { }
+
+    constexpr compact_optional& operator=(std::nullopt_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    constexpr compact_optional& operator=(const T& value) noexcept {
+        val_ = value;
+        return *this;
+    }
+
+    constexpr void reset() noexcept { val_ = Traits::empty_value(); }
+
+    constexpr void swap(compact_optional& other) noexcept { std::swap(val_, other.val_); }
+
+    constexpr bool has_value() const noexcept { return !Traits::is_empty(val_); }
+
+    constexpr explicit operator bool() const noexcept { return has_value(); }
+
+    constexpr const T& value() const {
+        if (!has_value()) {
+            throw std::bad_optional_access();
+        }
+        return val_;
+    }
+
+    constexpr T value_or(const T& default_value) const noexcept { return has_value() ? val_ : default_value; }
+
+    // unchecked access, returns the sentinel when empty
+    constexpr const T& operator*() const noexcept { return val_; }
+
+    constexpr const T* operator->() const noexcept { return &val_; }
+
+    friend constexpr bool operator==(const compact_optional& lhs, const compact_optional& rhs) noexcept {
+        if (lhs.has_value() != rhs.has_value()) {
+            return false;
+        }
+        return !lhs.has_value() || lhs.val_ == rhs.val_;
+    }
+
+    friend constexpr bool operator==(const compact_optional& opt, std::nullopt_t) noexcept { return !opt.has_value(); }
+
+private:
+    T val_;
 };
 
 } // namespace CustomSTL
 
-#endif
\ No newline at end of file
+#endif
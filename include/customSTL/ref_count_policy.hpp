@@ -0,0 +1,178 @@
+#ifndef CUSTOM_STL_REF_COUNT_POLICY_HPP
+#define CUSTOM_STL_REF_COUNT_POLICY_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace CustomSTL {
+    // Counting policy used by default, safe to share objects across threads.
+    // Increments can be relaxed since a new reference can only be created from an existing one, so nobody can observe
+    // the count reaching zero in between. Decrements need acq_rel so that every write made through other references
+    // happens before the object is destroyed by whichever thread drops the count to zero.
+    struct atomic_count_policy {
+        using count_type = std::atomic<unsigned long>;
+        // policy used for the weak count of a ControlBlock
+        using weak_policy = atomic_count_policy;
+
+        static void increment(count_type& count) noexcept { count.fetch_add(1, std::memory_order_relaxed); }
+        // returns true if this call dropped the count to zero
+        static bool decrement(count_type& count) noexcept { return count.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+        static unsigned long load(const count_type& count) noexcept { return count.load(std::memory_order_relaxed); }
+
+        // increments the count unless it already reached zero (e.g. weak_ptr::lock()), returns true on success
+        static bool increment_if_not_zero(count_type& count) noexcept {
+            unsigned long current = count.load(std::memory_order_relaxed);
+            while (current != 0) {
+                if (count.compare_exchange_weak(current, current + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Counting policy for objects that never leave the thread that created them (e.g. reactor threads).
+    // Plain integers, so copying/destroying a reference does not need a locked RMW instruction.
+    struct local_count_policy {
+        using count_type = unsigned long;
+        using weak_policy = local_count_policy;
+
+        static void increment(count_type& count) noexcept { ++count; }
+        // Once inlined, GCC 12+ sees a path where one reference deletes the object and another one then decrements or
+        // reads the count, and reports a use after free in optimized builds. That path needs the count to reach zero
+        // twice, which it cannot, but the count is a plain integer so nothing tells GCC otherwise.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuse-after-free"
+#endif
+        static bool decrement(count_type& count) noexcept { return --count == 0; }
+        static unsigned long load(const count_type& count) noexcept { return count; }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+#pragma GCC diagnostic pop
+#endif
+
+        static bool increment_if_not_zero(count_type& count) noexcept {
+            if (count == 0) {
+                return false;
+            }
+            ++count;
+            return true;
+        }
+    };
+
+    // Round robin index assigned to each thread the first time it touches a sharded count
+    inline size_t this_thread_shard() noexcept {
+        static std::atomic<size_t> next_shard { 0 };
+        thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed);
+        return shard;
+    }
+
+    /*
+    * Contention resistant counting policy for objects that are copied/destroyed by many cores at once.
+    * The references are spread over Shards padded shard counts, each thread incrementing "its" shard, and the
+    * total number of references is always exactly the sum of the shards. A separate central count holds one
+    * reference for every non zero shard, so it only reaches zero once the last shard is emptied, which is how we
+    * detect that the object must be destroyed without ever summing the shards.
+    *
+    * References are fungible: a decrement takes a reference from the caller's shard if it is non zero, otherwise
+    * from any other non zero shard (one must exist since the caller holds a reference). Shards never go negative,
+    * so there is never a moment where the shards sum to zero while a reference is still alive.
+    *
+    * The central line is only touched when a shard goes from 0 to 1 or 1 to 0, so this works best when every thread
+    * keeps at least one long lived reference of its own (e.g. its own copy of the handle) and copies from it.
+    * The price is memory (one cache line per shard) and an approximate use_count(), so only opt in for hot objects.
+    * The weak count of the ControlBlock stays a plain atomic.
+    */
+    template <size_t Shards = 16>
+    struct sharded_count_policy {
+        struct count_type {
+            struct alignas(64) Shard {
+                std::atomic<unsigned long> count { 0 };
+            };
+
+            alignas(64) std::atomic<unsigned long> central;
+            Shard shards[Shards];
+
+            explicit count_type(unsigned long initial) noexcept
+                : central { initial == 0 ? 0ul : 1ul }
+            {
+                shards[this_thread_shard() % Shards].count.store(initial, std::memory_order_relaxed);
+            }
+        };
+
+        using weak_policy = atomic_count_policy;
+
+        static void increment(count_type& count) noexcept {
+            std::atomic<unsigned long>& shard = count.shards[this_thread_shard() % Shards].count;
+
+            unsigned long current = shard.load(std::memory_order_relaxed);
+            while (true) {
+                if (current != 0) {
+                    if (shard.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+                        return;
+                    }
+                    continue;
+                }
+
+                // the shard is empty, it needs to take a reference on the central count before it can be used
+                count.central.fetch_add(1, std::memory_order_relaxed);
+                if (shard.compare_exchange_strong(current, 1, std::memory_order_relaxed)) {
+                    return;
+                }
+                // someone else populated the shard first, give back the central reference and retry
+                // (cannot reach zero, the caller holds a reference so some shard is non zero)
+                count.central.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        static bool decrement(count_type& count) noexcept {
+            size_t start = this_thread_shard() % Shards;
+
+            // the caller holds a reference, so at every instant at least one shard is non zero
+            for (size_t i = start; ; i = (i + 1) % Shards) {
+                std::atomic<unsigned long>& shard = count.shards[i].count;
+
+                unsigned long current = shard.load(std::memory_order_relaxed);
+                while (current != 0) {
+                    if (shard.compare_exchange_weak(current, current - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                        // the shard became empty, drop its reference on the central count
+                        return current == 1 && count.central.fetch_sub(1, std::memory_order_acq_rel) == 1;
+                    }
+                }
+            }
+        }
+
+        // approximate while other threads are updating the count
+        static unsigned long load(const count_type& count) noexcept {
+            unsigned long total = 0;
+            for (const auto& shard : count.shards) {
+                total += shard.count.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        // the object is alive as long as the central count is non zero
+        static bool increment_if_not_zero(count_type& count) noexcept {
+            if (!atomic_count_policy::increment_if_not_zero(count.central)) {
+                return false;
+            }
+
+            // we now hold a central reference, use it for our shard if it is empty, otherwise give it back
+            std::atomic<unsigned long>& shard = count.shards[this_thread_shard() % Shards].count;
+            unsigned long current = shard.load(std::memory_order_relaxed);
+            while (true) {
+                if (current == 0) {
+                    if (shard.compare_exchange_weak(current, 1, std::memory_order_relaxed)) {
+                        return true;
+                    }
+                } else if (shard.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+                    // cannot reach zero, our shard is non zero and holds its own central reference
+                    count.central.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+    };
+}
+
+#endif
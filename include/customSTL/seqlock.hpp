@@ -30,7 +30,7 @@ public:
         data_ = static_cast<Slot*>(addr);
 
         // default construct all slots
-        for (int i = 0; i < Capacity; ++i) {
+        for (size_t i = 0; i < Capacity; ++i) {
             new (data_ + i) Slot();
         }
     }
@@ -0,0 +1,246 @@
+#ifndef CUSTOM_STL_SHARED_LOCK_HPP
+#define CUSTOM_STL_SHARED_LOCK_HPP
+
+#include <chrono>
+#include <concepts>
+#include <mutex> // For std::defer_lock_t, std::try_to_lock_t & std::adopt_lock_t
+#include <source_location>
+#include <system_error>
+#include <utility>
+
+#include "lockable.hpp"
+#include "lock_profiler.hpp"
+
+namespace CustomSTL {
+    // RAII ownership of the shared side of a reader-writer lock, the counterpart of unique_lock for readers
+    template <SharedLockable Mutex>
+    class shared_lock {
+    public:
+        using mutex_type = Mutex;
+
+        shared_lock() noexcept
+            : shared_lock(std::source_location::current())
+        { }
+
+        // explicit, so that a source_location never converts to a lock
+        explicit shared_lock(std::source_location site) noexcept
+            : mt_ { nullptr }
+            , flag_ { false }
+            , probe_ { site }
+        { }
+
+        explicit shared_lock(mutex_type& m, std::source_location site = std::source_location::current())
+            : mt_ { &m }
+            , flag_ { false }
+            , probe_ { site }
+        { 
+            probe_.waiting();
+            mt_->lock_shared();
+            probe_.acquired();
+            flag_ = true;
+        }
+        
+        shared_lock(shared_lock&& other) noexcept
+            : mt_ { std::exchange(other.mt_, nullptr) }
+            , flag_ { std::exchange(other.flag_, false) }
+            , probe_ { other.probe_ }
+        { }
+
+        shared_lock(mutex_type& m, std::defer_lock_t, std::source_location site = std::source_location::current()) noexcept
+            : mt_ { &m }
+            , flag_ { false }
+            , probe_ { site }
+        { }
+
+        shared_lock(mutex_type& m, std::try_to_lock_t, std::source_location site = std::source_location::current())
+            : mt_ { &m }
+            , flag_ { false }
+            , probe_ { site }
+        {
+            probe_.waiting();
+            if (mt_->try_lock_shared()) {
+                flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
+            }
+        }
+
+        shared_lock(mutex_type& m, std::adopt_lock_t, std::source_location site = std::source_location::current())
+            : mt_ { &m }
+            , flag_ { true }
+            , probe_ { site }
+        {
+            probe_.adopted();
+        }
+
+        template <typename Rep, typename Period>
+        shared_lock(mutex_type& m, const std::chrono::duration<Rep, Period>& timeout_duration,
+                    std::source_location site = std::source_location::current())
+            : mt_ { &m }
+            , flag_ { false }
+            , probe_ { site }
+        {
+            probe_.waiting();
+            if (mt_->try_lock_shared_for(timeout_duration)) {
+                flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
+            }
+        }
+
+        template <typename Clock, typename Duration>
+        shared_lock(mutex_type& m, const std::chrono::time_point<Clock, Duration>& timeout_time,
+                    std::source_location site = std::source_location::current())
+            : mt_ { &m }
+            , flag_ { false }
+            , probe_ { site }
+        {
+            probe_.waiting();
+            if (mt_->try_lock_shared_until(timeout_time)) {
+                flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
+            }
+        }
+
+        ~shared_lock() {
+            if (flag_) {
+                probe_.released();
+                mt_->unlock_shared();
+                flag_ = false;
+            }
+        }
+
+        shared_lock(const shared_lock&) = delete;
+        shared_lock& operator=(const shared_lock&) = delete;
+
+        shared_lock& operator=(shared_lock&& other) {
+            if (this == &other) {
+                return *this;
+            }
+
+            if (flag_) {
+                probe_.released();
+                mt_->unlock_shared();
+            }
+
+            mt_ = std::exchange(other.mt_, nullptr);
+            flag_ = std::exchange(other.flag_, false);
+            probe_ = other.probe_;
+
+            return *this;
+        }
+
+        void lock() {
+            if (mt_ == nullptr) {
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
+            } else if (flag_) {
+                throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur));
+            }
+
+            probe_.waiting();
+            mt_->lock_shared();
+            probe_.acquired();
+            flag_ = true;
+        }
+
+        void unlock() {
+            if (mt_ == nullptr || !flag_) {
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
+            }
+
+            probe_.released();
+            mt_->unlock_shared();
+            flag_ = false;
+        }
+
+        bool try_lock() {
+            if (mt_ == nullptr) {
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
+            } else if (flag_) {
+                throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur));
+            }
+
+            probe_.waiting();
+            if (mt_->try_lock_shared()) {
+                flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
+            }
+
+            return flag_;
+        }
+
+        template <typename Rep, typename Period>
+        requires SharedTimedLockable<mutex_type>
+        bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
+            if (mt_ == nullptr) {
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
+            } else if (flag_) {
+                throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur));
+            }
+
+            probe_.waiting();
+            if (mt_->try_lock_shared_for(timeout_duration)) {
+                flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
+            }
+
+            return flag_;
+        }
+
+        template <typename Clock, typename Duration>
+        requires SharedTimedLockable<mutex_type>
+        bool try_lock_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
+            if (mt_ == nullptr) {
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
+            } else if (flag_) {
+                throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur));
+            }
+
+            probe_.waiting();
+            if (mt_->try_lock_shared_until(timeout_time)) {
+                flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
+            }
+
+            return flag_;
+        }
+
+        // gives up the association with the mutex without unlocking it, the hold time recorded for this guard ends here
+        mutex_type* release() noexcept {
+            if (flag_) {
+                probe_.released();
+            }
+            flag_ = false;
+            return std::exchange(mt_, nullptr);
+        }
+
+        void swap(shared_lock& other) noexcept {
+            std::swap(mt_, other.mt_);
+            std::swap(flag_, other.flag_);
+            std::swap(probe_, other.probe_);
+        }
+
+        mutex_type* mutex() const noexcept { return mt_; }
+
+        bool owns_lock() const noexcept { return flag_; }
+
+        explicit operator bool() const noexcept { return flag_; }
+
+    private:
+        Mutex* mt_;
+        bool flag_;
+        [[no_unique_address]] lock_probe probe_;
+    };
+}
+
+#endif
\ No newline at end of file
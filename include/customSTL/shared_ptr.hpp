@@ -1,60 +1,141 @@
 #ifndef CUSTOM_STL_SHARED_PTR_HPP
 #define CUSTOM_STL_SHARED_PTR_HPP
 
-#include <atomic>
 #include <concepts>
+#include <cstddef>
+#include <memory> // For std::default_delete<T>, std::allocator<T> & std::allocator_traits
+#include <new>
 #include <type_traits>
+#include <utility>
+
+#include "ref_count_policy.hpp"
 
 namespace CustomSTL {
-    template <typename T>
+    // Type erased control block.
+    // Only the derived blocks know the type of the managed object and how the object/block was allocated,
+    // which is why shared_ptr<T> can point to a block created for a derived type, a custom deleter or an allocator.
+    // weak_count_ holds the number of weak_ptr objects + 1 while strong_count_ is non zero,
+    // so that the block is only destroyed once by whichever count reaches zero last.
+    template <typename Policy = atomic_count_policy>
     class ControlBlock {
     public:
-        using pointer = T*;
-        using count_size = std::atomic<unsigned long>;
+        using count_size = typename Policy::count_type;
+        using weak_policy = typename Policy::weak_policy;
 
     private:
-        pointer ptr_;
         count_size strong_count_;
-        count_size weak_count_;
+        typename weak_policy::count_type weak_count_;
+
+    protected:
+        ControlBlock() noexcept
+            : strong_count_ { 1 }
+            , weak_count_ { 1 }
+        { }
+
+        virtual ~ControlBlock() = default;
+
+        // destroys the managed object, called when the last shared_ptr is released
+        virtual void destroy_object() noexcept = 0;
+        // frees the control block itself, called when the last weak reference is released
+        virtual void destroy_self() noexcept = 0;
 
     public:
-        explicit ControlBlock(pointer ptr) noexcept
+        ControlBlock(const ControlBlock&) = delete;
+        ControlBlock& operator=(const ControlBlock&) = delete;
+
+        void add_strong() noexcept { Policy::increment(strong_count_); }
+        void release_strong() noexcept {
+            if (Policy::decrement(strong_count_)) {
+                destroy_object();
+                release_weak();
+            }
+        }
+        // used by weak_ptr::lock(), fails once the object has been destroyed
+        bool try_add_strong() noexcept { return Policy::increment_if_not_zero(strong_count_); }
+        unsigned long get_strong_count() const noexcept { return Policy::load(strong_count_); }
+
+        void add_weak() noexcept { weak_policy::increment(weak_count_); }
+        void release_weak() noexcept {
+            if (weak_policy::decrement(weak_count_)) {
+                destroy_self();
+            }
+        }
+        unsigned long get_weak_count() const noexcept {
+            unsigned long weak = weak_policy::load(weak_count_);
+            return get_strong_count() == 0 ? weak : weak - 1;
+        }
+    };
+
+    // Control block for shared_ptr objects constructed from a raw pointer.
+    // The object and the control block live in two separate allocations.
+    template <typename Y, typename Deleter, typename Policy = atomic_count_policy>
+    class PointerControlBlock final : public ControlBlock<Policy> {
+    private:
+        Y* ptr_;
+        [[no_unique_address]] Deleter deleter_;
+
+    public:
+        PointerControlBlock(Y* ptr, Deleter deleter) noexcept
             : ptr_ { ptr }
-            , strong_count_ { 1 }
-            , weak_count_ { 0 }
+            , deleter_ { std::move(deleter) }
         { }
 
-        ~ControlBlock() = default;
+    private:
+        void destroy_object() noexcept override { deleter_(ptr_); }
+        void destroy_self() noexcept override { delete this; }
+    };
 
-        pointer get() const noexcept { return ptr_; }
+    // Control block for make_shared/allocate_shared.
+    // The object is stored inline after the counts, so the object and control block share a single allocation
+    // (and usually the same cache line). Alloc is always rebound to T, the block rebinds it to itself to free memory.
+    template <typename T, typename Alloc, typename Policy = atomic_count_policy>
+    class InplaceControlBlock final : public ControlBlock<Policy> {
+    private:
+        using alloc_traits = std::allocator_traits<Alloc>;
+        using block_alloc = typename alloc_traits::template rebind_alloc<InplaceControlBlock>;
+        using block_alloc_traits = std::allocator_traits<block_alloc>;
 
-        void add_strong() { ++strong_count_; }
-        void release_strong() { 
-            --strong_count_;
+        [[no_unique_address]] Alloc alloc_;
+        alignas(T) std::byte storage_[sizeof(T)];
 
-            if (strong_count_ == 0) {
-                delete ptr_;
-                ptr_ = nullptr;
+    public:
+        template <typename... Args>
+        explicit InplaceControlBlock(const Alloc& alloc, Args&&... args)
+            : alloc_ { alloc }
+        {
+            alloc_traits::construct(alloc_, get(), std::forward<Args>(args)...);
+        }
 
-                if (weak_count_ == 0) {
-                    delete this;
-                }
+        T* get() noexcept { return std::launder(reinterpret_cast<T*>(&storage_)); }
+
+        template <typename... Args>
+        static InplaceControlBlock* create(const Alloc& alloc, Args&&... args) {
+            block_alloc allocator(alloc);
+            InplaceControlBlock* block = block_alloc_traits::allocate(allocator, 1);
+            try {
+                ::new (static_cast<void*>(block)) InplaceControlBlock(alloc, std::forward<Args>(args)...);
+            } catch (...) {
+                block_alloc_traits::deallocate(allocator, block, 1);
+                throw;
             }
+            return block;
         }
-        unsigned long get_strong_count() const noexcept { return strong_count_.load(); }
 
-        void add_weak() { ++weak_count_; }
-        void release_weak() { 
-            --weak_count_;
-            if (weak_count_ == 0 && strong_count_ == 0) {
-                delete ptr_;
-                ptr_ = nullptr;
-                delete this;
-            }
+    private:
+        void destroy_object() noexcept override { alloc_traits::destroy(alloc_, get()); }
+
+        void destroy_self() noexcept override {
+            block_alloc allocator(alloc_);
+            this->~InplaceControlBlock();
+            block_alloc_traits::deallocate(allocator, this, 1);
         }
-        unsigned long get_weak_count() const noexcept { return weak_count_.load(); }
     };
 
+    // The type of the single block allocated by allocate_shared<T>(Alloc).
+    // Useful for sizing pools, e.g. ObjectPool<shared_block<T, pool_allocator<T>>>.
+    template <typename T, typename Alloc = std::allocator<T>, typename Policy = atomic_count_policy>
+    using shared_block = InplaceControlBlock<T, typename std::allocator_traits<Alloc>::template rebind_alloc<T>, Policy>;
+
     template <typename Y, typename T>
     concept PointerCompatible = std::convertible_to<Y*, T*> ||
                                 (std::is_array_v<Y> &&
@@ -64,16 +145,44 @@ namespace CustomSTL {
                                                 >
                                 );
 
-    template <typename T>
+    // Policy selects how the reference counts are updated, see atomic_count_policy/local_count_policy.
+    // shared_ptr objects with different policies are different types and cannot be converted into each other.
+    template <typename T, typename Policy = atomic_count_policy>
+    class shared_ptr;
+
+    template <typename T, typename Policy, typename Alloc, typename... Args>
+    shared_ptr<T, Policy> allocate_shared_with_policy(const Alloc& alloc, Args&&... args);
+
+    template <typename T, typename Policy>
+    class weak_ptr;
+
+    template <typename T, typename Policy>
     class shared_ptr {
     public:
         using element_type = T;
         using pointer = T*;
+        using policy_type = Policy;
+        using control_block = ControlBlock<Policy>;
 
     private:
         pointer ptr_;
-        ControlBlock<T>* control_ptr_;
-    
+        control_block* control_ptr_;
+
+        template <typename Y, typename P>
+        friend class shared_ptr;
+
+        template <typename Y, typename P>
+        friend class weak_ptr;
+
+        template <typename U, typename P, typename Alloc, typename... Args>
+        friend shared_ptr<U, P> allocate_shared_with_policy(const Alloc& alloc, Args&&... args);
+
+        // adopts a control block whose strong count has already been incremented for us
+        shared_ptr(pointer ptr, control_block* control_ptr) noexcept
+            : ptr_ { ptr }
+            , control_ptr_ { control_ptr }
+        { }
+
     public:
         constexpr shared_ptr() noexcept
             : ptr_ { nullptr }
@@ -85,11 +194,28 @@ namespace CustomSTL {
             , control_ptr_ { nullptr }
         { }
 
-        explicit shared_ptr(pointer ptr)
-            : ptr_ { ptr }
-            , control_ptr_ { new ControlBlock(ptr) }
+        // the deleter is captured with the static type Y, so deleting through shared_ptr<Base> is still correct
+        template <typename Y>
+        requires PointerCompatible<Y, T>
+        explicit shared_ptr(Y* ptr)
+            : shared_ptr(ptr, std::default_delete<Y>())
         { }
 
+        template <typename Y, typename Deleter>
+        requires PointerCompatible<Y, T> && std::invocable<Deleter&, Y*>
+        shared_ptr(Y* ptr, Deleter d)
+            : ptr_ { ptr }
+            , control_ptr_ { nullptr }
+        {
+            try {
+                control_ptr_ = new PointerControlBlock<Y, Deleter, Policy>(ptr, d);
+            } catch (...) {
+                // we own the pointer as soon as the constructor is called, so it must not leak
+                d(ptr);
+                throw;
+            }
+        }
+
         ~shared_ptr() noexcept {
             release();
         }
@@ -103,25 +229,42 @@ namespace CustomSTL {
             }
         }
 
+        template <typename Y>
+        requires PointerCompatible<Y, T>
+        shared_ptr(const shared_ptr<Y, Policy>& other) noexcept
+            : ptr_ { other.ptr_ }
+            , control_ptr_ { other.control_ptr_ }
+        {
+            if (control_ptr_) {
+                control_ptr_->add_strong();
+            }
+        }
+
         shared_ptr(shared_ptr&& other) noexcept
             : ptr_ { std::exchange(other.ptr_, nullptr) }
             , control_ptr_ { std::exchange(other.control_ptr_, nullptr) }
         { }
 
+        template <typename Y>
+        requires PointerCompatible<Y, T>
+        shared_ptr(shared_ptr<Y, Policy>&& other) noexcept
+            : ptr_ { std::exchange(other.ptr_, nullptr) }
+            , control_ptr_ { std::exchange(other.control_ptr_, nullptr) }
+        { }
+
         shared_ptr& operator=(const shared_ptr& other) noexcept {
             if (this == &other) {
                 return *this;
             }
 
-            if (control_ptr_) {
-                control_ptr_->release_strong();
+            if (other.control_ptr_) {
+                other.control_ptr_->add_strong();
             }
 
+            // released after the add in case other is owned by the object we are releasing
+            release();
             ptr_ = other.ptr_;
             control_ptr_ = other.control_ptr_;
-            if (control_ptr_) {
-                control_ptr_->add_strong();
-            }
 
             return *this;
         }
@@ -131,22 +274,27 @@ namespace CustomSTL {
                 return *this;
             }
 
-            if (control_ptr_) {
-                control_ptr_->release_strong();
-            }
-
+            release();
             ptr_ = std::exchange(other.ptr_, nullptr);
             control_ptr_ = std::exchange(other.control_ptr_, nullptr);
 
             return *this;
         }
 
-        void reset(pointer ptr = nullptr) noexcept {
+        void reset() noexcept {
             release();
-            if (ptr) {
-                ptr_ = ptr;
-                control_ptr_ = new ControlBlock<T>(ptr);
-            }
+        }
+
+        template <typename Y>
+        requires PointerCompatible<Y, T>
+        void reset(Y* ptr) {
+            shared_ptr(ptr).swap(*this);
+        }
+
+        template <typename Y, typename Deleter>
+        requires PointerCompatible<Y, T> && std::invocable<Deleter&, Y*>
+        void reset(Y* ptr, Deleter d) {
+            shared_ptr(ptr, std::move(d)).swap(*this);
         }
 
         void swap(shared_ptr& other) noexcept {
@@ -156,21 +304,22 @@ namespace CustomSTL {
 
         long use_count() const noexcept { return control_ptr_ ? control_ptr_->get_strong_count() : 0; }
 
-        constexpr bool owner_before(const shared_ptr& other) const noexcept { return control_ptr_ < other.control_ptr_; }
+        template <typename Y>
+        constexpr bool owner_before(const shared_ptr<Y, Policy>& other) const noexcept { return control_ptr_ < other.control_ptr_; }
 
         constexpr pointer get() noexcept { return ptr_; }
-        constexpr const pointer get() const noexcept { return ptr_; }
+        constexpr pointer get() const noexcept { return ptr_; }
 
         constexpr T& operator*() noexcept { return *ptr_; }
         constexpr const T& operator*() const noexcept { return *ptr_; }
-        
+
         constexpr pointer operator->() noexcept { return ptr_; }
-        constexpr const pointer operator->() const noexcept { return ptr_; }
+        constexpr pointer operator->() const noexcept { return ptr_; }
 
         constexpr explicit operator bool() const noexcept { return ptr_; }
 
     private:
-        void release() {
+        void release() noexcept {
             if (control_ptr_) {
                 control_ptr_->release_strong();
             }
@@ -179,16 +328,49 @@ namespace CustomSTL {
         }
     };
 
-    template <typename T, typename U>
-    constexpr bool operator==(const CustomSTL::shared_ptr<T> lhs, const CustomSTL::shared_ptr<U> rhs) noexcept {
+    template <typename T, typename U, typename Policy>
+    constexpr bool operator==(const CustomSTL::shared_ptr<T, Policy>& lhs, const CustomSTL::shared_ptr<U, Policy>& rhs) noexcept {
         return lhs.get() == rhs.get();
     }
 
+    template <typename T, typename Policy, typename Alloc, typename... Args>
+    shared_ptr<T, Policy> allocate_shared_with_policy(const Alloc& alloc, Args&&... args) {
+        using block_type = shared_block<T, Alloc, Policy>;
+        typename std::allocator_traits<Alloc>::template rebind_alloc<T> object_alloc(alloc);
+
+        block_type* block = block_type::create(object_alloc, std::forward<Args>(args)...);
+        return shared_ptr<T, Policy>(block->get(), block);
+    }
+
+    // Allocates the object and its control block in a single allocation obtained from alloc.
+    // alloc can be any allocator, e.g. arena_allocator or pool_allocator to take the memory from an Arena/ObjectPool.
+    template <typename T, typename Alloc, typename... Args>
+    shared_ptr<T> allocate_shared(const Alloc& alloc, Args&&... args) {
+        return allocate_shared_with_policy<T, atomic_count_policy>(alloc, std::forward<Args>(args)...);
+    }
+
     template <typename T, typename... Args>
     shared_ptr<T> make_shared(Args&&... args) {
-       // TODO
-       return nullptr; 
+        return CustomSTL::allocate_shared<T>(std::allocator<T>(), std::forward<Args>(args)...);
+    }
+
+    // shared_ptr with non atomic reference counts. Must not be copied/destroyed concurrently from multiple threads.
+    template <typename T>
+    using local_shared_ptr = shared_ptr<T, local_count_policy>;
+
+    template <typename T, typename... Args>
+    local_shared_ptr<T> make_local_shared(Args&&... args) {
+        return allocate_shared_with_policy<T, local_count_policy>(std::allocator<T>(), std::forward<Args>(args)...);
+    }
+
+    // shared_ptr with sharded reference counts, for objects copied/destroyed by many threads at once
+    template <typename T>
+    using sharded_shared_ptr = shared_ptr<T, sharded_count_policy<>>;
+
+    template <typename T, typename... Args>
+    sharded_shared_ptr<T> make_sharded_shared(Args&&... args) {
+        return allocate_shared_with_policy<T, sharded_count_policy<>>(std::allocator<T>(), std::forward<Args>(args)...);
     }
-} 
+}
 
-#endif
\ No newline at end of file
+#endif
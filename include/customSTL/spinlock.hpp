@@ -0,0 +1,282 @@
+#ifndef CUSTOM_STL_SPINLOCK_HPP
+#define CUSTOM_STL_SPINLOCK_HPP
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <immintrin.h>
+#include <stdexcept>
+#include <thread>
+
+namespace CustomSTL {
+
+// Exponential backoff for spin loops: 1, 2, 4 ... MaxSpins pause instructions per round.
+// Once saturated, the thread yields, and with MaySleep it briefly sleeps if it keeps waiting: when there are more
+// threads than cores the thread we are waiting for may not be running, and sched_yield() alone often picks us again.
+// FIFO locks must not sleep, the lock is handed to the waiter at the front and nobody can take it while it sleeps.
+template <uint32_t MaxSpins = 1024, bool MaySleep = true>
+class exponential_backoff {
+public:
+    void pause() noexcept {
+        if (spins_ < MaxSpins) {
+            for (uint32_t i = 0; i < spins_; ++i) {
+                _mm_pause();
+            }
+            spins_ <<= 1;
+        } else if (!MaySleep || yields_ < MAX_YIELDS) {
+            ++yields_;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    void reset() noexcept {
+        spins_ = 1;
+        yields_ = 0;
+    }
+
+private:
+    static constexpr uint32_t MAX_YIELDS = 64;
+
+    uint32_t spins_ = 1;
+    uint32_t yields_ = 0;
+};
+
+// try_lock_for/try_lock_until for locks that can only be acquired without queueing through try_lock()
+template <typename Lock, typename Clock, typename Duration>
+bool poll_try_lock_until(Lock& lock, const std::chrono::time_point<Clock, Duration>& timeout_time) {
+    exponential_backoff backoff;
+    do {
+        if (lock.try_lock()) {
+            return true;
+        }
+        backoff.pause();
+    } while (Clock::now() < timeout_time);
+    return false;
+}
+
+/*
+* Test and test-and-set spinlock.
+* Waiters spin on a plain load, which stays in their own cache, and only attempt the exchange (which takes the line
+* exclusive) once the lock looks free, backing off exponentially between attempts to limit the stampede on release.
+* Not fair: the thread that just released the lock often reacquires it first.
+*/
+class spinlock {
+public:
+    spinlock() noexcept = default;
+
+    spinlock(const spinlock&) = delete;
+    spinlock& operator=(const spinlock&) = delete;
+
+    void lock() noexcept {
+        exponential_backoff backoff;
+        while (locked_.exchange(true, std::memory_order_acquire)) {
+            while (locked_.load(std::memory_order_relaxed)) {
+                backoff.pause();
+            }
+        }
+    }
+
+    bool try_lock() noexcept {
+        return !locked_.load(std::memory_order_relaxed) && !locked_.exchange(true, std::memory_order_acquire);
+    }
+
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout_duration);
+    }
+
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        return poll_try_lock_until(*this, timeout_time);
+    }
+
+    void unlock() noexcept { locked_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> locked_ { false };
+};
+
+/*
+* Fair (FIFO) ticket lock.
+* Every waiter takes a ticket and spins until now_serving_ reaches it, backing off in proportion to its distance
+* from the front of the queue. All waiters still spin on the same line, which is written on every handoff.
+* try_lock_for/try_lock_until only succeed while the lock is free, as a ticket cannot be given back.
+*/
+class ticket_lock {
+public:
+    ticket_lock() noexcept = default;
+
+    ticket_lock(const ticket_lock&) = delete;
+    ticket_lock& operator=(const ticket_lock&) = delete;
+
+    void lock() noexcept {
+        uint32_t ticket = next_ticket_.fetch_add(1, std::memory_order_relaxed);
+        // pause and yield only, a waiter sleeping when its turn comes stalls everyone queued behind it
+        exponential_backoff<1024, false> backoff;
+        while (true) {
+            uint32_t serving = now_serving_.load(std::memory_order_acquire);
+            if (serving == ticket) {
+                return;
+            }
+
+            // waiters further back in the queue poll less often
+            for (uint32_t i = 1; i < ticket - serving; ++i) {
+                _mm_pause();
+            }
+            backoff.pause();
+        }
+    }
+
+    bool try_lock() noexcept {
+        uint32_t serving = now_serving_.load(std::memory_order_acquire);
+        uint32_t expected = serving;
+        return next_ticket_.compare_exchange_strong(expected, serving + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout_duration);
+    }
+
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        return poll_try_lock_until(*this, timeout_time);
+    }
+
+    // only the holder writes now_serving_, so a plain store is enough
+    void unlock() noexcept {
+        now_serving_.store(now_serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<uint32_t> next_ticket_ { 0 };
+    alignas(64) std::atomic<uint32_t> now_serving_ { 0 };
+};
+
+/*
+* MCS queue lock.
+* Waiters form a linked queue of nodes and each one spins on a flag in its own node (its own cache line), which the
+* previous holder clears on unlock. A handoff therefore only touches the successor's line, so the lock stays fast
+* with many waiters, and it is FIFO fair.
+*
+* Nodes come from a small thread local cache so that lock()/unlock() keep the standard signatures: a thread may hold
+* at most MaxHeldLocks MCS locks at the same time.
+*/
+class mcs_lock {
+public:
+    static constexpr uint32_t MaxHeldLocks = 16;
+
+    mcs_lock() noexcept = default;
+
+    mcs_lock(const mcs_lock&) = delete;
+    mcs_lock& operator=(const mcs_lock&) = delete;
+
+    void lock() {
+        Node* node = acquire_node();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+
+        Node* predecessor = tail_.exchange(node, std::memory_order_acq_rel);
+        if (predecessor != nullptr) {
+            predecessor->next.store(node, std::memory_order_release);
+
+            // Polling our own line costs the other threads nothing, and the predecessor hands the lock straight to
+            // us, so any backoff would only delay the handoff.
+            while (node->locked.load(std::memory_order_acquire)) {
+                _mm_pause();
+            }
+        }
+
+        owner_ = node;
+    }
+
+    bool try_lock() {
+        Node* node = acquire_node();
+        node->next.store(nullptr, std::memory_order_relaxed);
+
+        Node* expected = nullptr;
+        if (tail_.compare_exchange_strong(expected, node, std::memory_order_acquire, std::memory_order_relaxed)) {
+            owner_ = node;
+            return true;
+        }
+
+        release_node(node);
+        return false;
+    }
+
+    template <typename Rep, typename Period>
+    bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
+        return try_lock_until(std::chrono::steady_clock::now() + timeout_duration);
+    }
+
+    template <typename Clock, typename Duration>
+    bool try_lock_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
+        return poll_try_lock_until(*this, timeout_time);
+    }
+
+    void unlock() noexcept {
+        Node* node = owner_;
+        Node* successor = node->next.load(std::memory_order_acquire);
+
+        if (successor == nullptr) {
+            // nobody is queued behind us, try to mark the lock as free
+            Node* expected = node;
+            if (tail_.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+                release_node(node);
+                return;
+            }
+
+            // a waiter swapped itself into tail_ but has not linked itself to our node yet
+            while ((successor = node->next.load(std::memory_order_acquire)) == nullptr) {
+                _mm_pause();
+            }
+        }
+
+        successor->locked.store(false, std::memory_order_release);
+        release_node(node);
+    }
+
+private:
+    struct alignas(64) Node {
+        std::atomic<Node*> next { nullptr };
+        std::atomic<bool> locked { false };
+    };
+
+    struct NodeCache {
+        Node nodes[MaxHeldLocks];
+        uint32_t free_mask = (MaxHeldLocks == 32) ? ~0u : (1u << MaxHeldLocks) - 1;
+    };
+
+    static NodeCache& node_cache() noexcept {
+        thread_local NodeCache cache;
+        return cache;
+    }
+
+    static Node* acquire_node() {
+        NodeCache& cache = node_cache();
+        if (cache.free_mask == 0) [[unlikely]] {
+            throw std::runtime_error("mcs_lock: too many MCS locks held by this thread");
+        }
+
+        uint32_t index = std::countr_zero(cache.free_mask);
+        cache.free_mask &= ~(1u << index);
+        return &cache.nodes[index];
+    }
+
+    static void release_node(Node* node) noexcept {
+        NodeCache& cache = node_cache();
+        cache.free_mask |= 1u << (node - cache.nodes);
+    }
+
+    static_assert(MaxHeldLocks <= 32, "free nodes are tracked in a 32 bit mask");
+
+    alignas(64) std::atomic<Node*> tail_ { nullptr };
+    Node* owner_ = nullptr; // only accessed by the thread holding the lock
+};
+
+} // namespace CustomSTL
+
+#endif
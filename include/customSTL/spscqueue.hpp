@@ -4,6 +4,7 @@
 #include <cstddef>
 #include <iostream>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace CustomSTL {
@@ -39,7 +40,8 @@ public:
             return false;
         }
 
-        output = data_[head_idx];
+        // moved out, so move-only types (e.g. inplace_move_only_function tasks) can be passed through the queue
+        output = std::move(data_[head_idx]);
         head_.store((head_idx + 1) % (Capacity + 1), std::memory_order_release);
         return true;
     }
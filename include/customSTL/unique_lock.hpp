@@ -1,73 +1,113 @@
 #ifndef CUSTOM_STL_UNIQUE_LOCK_HPP
 #define CUSTOM_STL_UNIQUE_LOCK_HPP
 
+#include <chrono>
 #include <concepts>
+#include <mutex> // For std::defer_lock_t, std::try_to_lock_t & std::adopt_lock_t
+#include <source_location>
+#include <system_error>
+#include <utility>
+
+#include "lockable.hpp"
+#include "lock_profiler.hpp"
 
 namespace CustomSTL {
-    template <typename Mutex>
+    template <BasicLockable Mutex>
     class unique_lock {
     public:
         using mutex_type = Mutex;
 
         unique_lock() noexcept
+            : unique_lock(std::source_location::current())
+        { }
+
+        // explicit, so that a source_location never converts to a lock
+        explicit unique_lock(std::source_location site) noexcept
             : mt_ { nullptr }
             , flag_ { false }
+            , probe_ { site }
         { }
 
-        explicit unique_lock(mutex_type& m)
-        : mt_ { &m }
-        , flag_ { false }
+        explicit unique_lock(mutex_type& m, std::source_location site = std::source_location::current())
+            : mt_ { &m }
+            , flag_ { false }
+            , probe_ { site }
         { 
+            probe_.waiting();
             mt_->lock();
+            probe_.acquired();
             flag_ = true;
         }
         
         unique_lock(unique_lock&& other) noexcept
             : mt_ { std::exchange(other.mt_, nullptr) }
             , flag_ { std::exchange(other.flag_, false) }
+            , probe_ { other.probe_ }
         { }
 
-        unique_lock(mutex_type& m, std::defer_lock_t t) noexcept
+        unique_lock(mutex_type& m, std::defer_lock_t, std::source_location site = std::source_location::current()) noexcept
             : mt_ { &m }
             , flag_ { false }
+            , probe_ { site }
         { }
 
-        unique_lock(mutex_type& m, std::try_to_lock_t t)
+        unique_lock(mutex_type& m, std::try_to_lock_t, std::source_location site = std::source_location::current())
             : mt_ { &m }
             , flag_ { false }
+            , probe_ { site }
         {
-            if (mt_.try_lock()) {
+            probe_.waiting();
+            if (mt_->try_lock()) {
                 flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
             }
         }
 
-        unique_lock(mutex_type& m, std::adopt_lock_t t)
+        unique_lock(mutex_type& m, std::adopt_lock_t, std::source_location site = std::source_location::current())
             : mt_ { &m }
             , flag_ { true }
-        { }
+            , probe_ { site }
+        {
+            probe_.adopted();
+        }
 
         template <typename Rep, typename Period>
-        unique_lock(mutex_type& m, const std::chrono::duration<Rep, Period>& timeout_duration)
+        unique_lock(mutex_type& m, const std::chrono::duration<Rep, Period>& timeout_duration,
+                    std::source_location site = std::source_location::current())
             : mt_ { &m }
             , flag_ { false }
+            , probe_ { site }
         {
-            if (mt_.try_lock_for(timeout_duration)) {
+            probe_.waiting();
+            if (mt_->try_lock_for(timeout_duration)) {
                 flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
             }
         }
 
         template <typename Clock, typename Duration>
-        unique_lock(mutex_type& m, const std::chrono::time_point<Clock, Duration>& timeout_time)
+        unique_lock(mutex_type& m, const std::chrono::time_point<Clock, Duration>& timeout_time,
+                    std::source_location site = std::source_location::current())
             : mt_ { &m }
             , flag_ { false }
+            , probe_ { site }
         {
-            if (mt_.try_lock_until(timeout_time)) {
+            probe_.waiting();
+            if (mt_->try_lock_until(timeout_time)) {
                 flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
             }
         }
 
         ~unique_lock() {
             if (flag_) {
+                probe_.released();
                 mt_->unlock();
                 flag_ = false;
             }
@@ -82,84 +122,123 @@ namespace CustomSTL {
             }
 
             if (flag_) {
+                probe_.released();
                 mt_->unlock();
             }
 
             mt_ = std::exchange(other.mt_, nullptr);
             flag_ = std::exchange(other.flag_, false);
+            probe_ = other.probe_;
 
             return *this;
         }
 
         void lock() {
             if (mt_ == nullptr) {
-                throw std::system_error(std::errc::operation_not_permitted());
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
             } else if (flag_) {
-                throw std::system_error(std::errc::resource_deadlock_would_occur());
+                throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur));
             }
 
+            probe_.waiting();
             mt_->lock();
+            probe_.acquired();
             flag_ = true;
         }
 
         void unlock() {
             if (mt_ == nullptr || !flag_) {
-                throw std::system_error(std::errc::operation_not_permitted());
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
             }
 
+            probe_.released();
             mt_->unlock();
             flag_ = false;
         }
 
-        bool try_lock() requires std::lockable<mutex_type> {
+        bool try_lock() requires Lockable<mutex_type> {
             if (mt_ == nullptr) {
-                throw std::system_error(std::errc::operation_not_permitted());
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
             } else if (flag_) {
-                throw std::system_error(std::errc::resource_deadlock_would_occur());
+                throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur));
             }
 
+            probe_.waiting();
             if (mt_->try_lock()) {
                 flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
             }
 
             return flag_;
         }
 
         template <typename Rep, typename Period>
-        requires std::timed_lockable<mutex_type>
+        requires TimedLockable<mutex_type>
         bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout_duration) {
             if (mt_ == nullptr) {
-                throw std::system_error(std::errc::operation_not_permitted());
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
             } else if (flag_) {
-                throw std::system_error(std::errc::resource_deadlock_would_occur());
+                throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur));
             }
 
+            probe_.waiting();
             if (mt_->try_lock_for(timeout_duration)) {
                 flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
             }
 
             return flag_;
         }
 
         template <typename Clock, typename Duration>
-        requires std::timed_lockable<mutex_type>
+        requires TimedLockable<mutex_type>
         bool try_lock_until(const std::chrono::time_point<Clock, Duration>& timeout_time) {
             if (mt_ == nullptr) {
-                throw std::system_error(std::errc::operation_not_permitted());
+                throw std::system_error(std::make_error_code(std::errc::operation_not_permitted));
             } else if (flag_) {
-                throw std::system_error(std::errc::resource_deadlock_would_occur());
+                throw std::system_error(std::make_error_code(std::errc::resource_deadlock_would_occur));
             }
 
+            probe_.waiting();
             if (mt_->try_lock_until(timeout_time)) {
                 flag_ = true;
+                probe_.acquired();
+            } else {
+                probe_.failed();
             }
 
             return flag_;
         }
 
+        // gives up the association with the mutex without unlocking it, the hold time recorded for this guard ends here
+        mutex_type* release() noexcept {
+            if (flag_) {
+                probe_.released();
+            }
+            flag_ = false;
+            return std::exchange(mt_, nullptr);
+        }
+
+        void swap(unique_lock& other) noexcept {
+            std::swap(mt_, other.mt_);
+            std::swap(flag_, other.flag_);
+            std::swap(probe_, other.probe_);
+        }
+
+        mutex_type* mutex() const noexcept { return mt_; }
+
+        bool owns_lock() const noexcept { return flag_; }
+
+        explicit operator bool() const noexcept { return flag_; }
+
     private:
         Mutex* mt_;
         bool flag_;
+        [[no_unique_address]] lock_probe probe_;
     };
 }
 
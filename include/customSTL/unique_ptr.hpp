@@ -2,7 +2,9 @@
 #define CUSTOM_STL_UNIQUE_PTR_HPP
 
 #include <concepts>
+#include <cstddef>
 #include <memory> // For std::default_delete<T>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -103,7 +105,9 @@ namespace CustomSTL {
                 return *this;
             }
 
-            get_deleter()(ptr_);
+            if (ptr_) {
+                get_deleter()(ptr_);
+            }
             ptr_ = std::exchange(other.ptr_, nullptr);
             static_cast<Deleter&>(*this) = std::move(other.get_deleter());
 
@@ -121,7 +125,10 @@ namespace CustomSTL {
         void reset(pointer newPtr = nullptr) noexcept {
             // In case user passes in the original pointer
             if (ptr_ != newPtr) {
-                get_deleter()(ptr_);
+                // deleters are never called with nullptr
+                if (ptr_) {
+                    get_deleter()(ptr_);
+                }
                 ptr_ = newPtr;
             }
         }
@@ -133,7 +140,7 @@ namespace CustomSTL {
 
         constexpr pointer get() noexcept { return ptr_; }
 
-        constexpr const pointer get() const noexcept { return ptr_; }
+        constexpr pointer get() const noexcept { return ptr_; }
 
         constexpr Deleter& get_deleter() noexcept { return static_cast<Deleter&>(*this); }
 
@@ -147,7 +154,7 @@ namespace CustomSTL {
 
         constexpr pointer operator->() noexcept { return ptr_; }
 
-        constexpr const pointer operator->() const noexcept { return ptr_; }
+        constexpr pointer operator->() const noexcept { return ptr_; }
     };
 
     // Partial template specialization for arrays
@@ -192,7 +199,9 @@ namespace CustomSTL {
                 return *this;
             }
 
-            get_deleter()(ptr_);
+            if (ptr_) {
+                get_deleter()(ptr_);
+            }
             ptr_ = std::exchange(other.ptr_, nullptr);
             static_cast<Deleter&>(*this) = std::move(other.get_deleter());
 
@@ -214,7 +223,10 @@ namespace CustomSTL {
                  std::convertible_to<U(*)[], element_type(*)[]>)
         {
             if (ptr_ != newPtr) {
-                get_deleter()(ptr_);
+                // deleters are never called with nullptr
+                if (ptr_) {
+                    get_deleter()(ptr_);
+                }
                 ptr_ = newPtr;
             }
         }
@@ -230,7 +242,7 @@ namespace CustomSTL {
 
         constexpr pointer get() noexcept { return ptr_; }
 
-        constexpr const pointer get() const noexcept { return ptr_; }
+        constexpr pointer get() const noexcept { return ptr_; }
 
         constexpr Deleter& get_deleter() noexcept { return static_cast<Deleter&>(*this); }
 
@@ -241,32 +253,101 @@ namespace CustomSTL {
         constexpr T& operator[](std::size_t index) const { return ptr_[index]; }
     };
 
+    // Type erased operations on an object living in a small buffer, generated for each concrete type U.
+    // The buffer holds the object itself when it is stored inline, and a void* to the heap object otherwise.
+    struct SmallObjectOperations {
+        void (*destroy)(void* storage) noexcept;
+        // move constructs the object from src_storage into dst_storage and destroys the source,
+        // returns the address of the new object
+        void* (*relocate)(void* dst_storage, void* src_storage) noexcept;
+        bool is_inline;
+    };
+
+    // objects of type U can be stored inline in a buffer of BufferSize bytes aligned to std::max_align_t
+    template <typename U, std::size_t BufferSize>
+    inline constexpr bool fits_small_buffer = sizeof(U) <= BufferSize &&
+                                              alignof(U) <= alignof(std::max_align_t) &&
+                                              std::is_nothrow_move_constructible_v<U>;
+
+    template <typename U>
+    inline constexpr SmallObjectOperations inline_object_operations {
+        [](void* storage) noexcept { std::launder(static_cast<U*>(storage))->~U(); },
+        [](void* dst_storage, void* src_storage) noexcept -> void* {
+            U* src = std::launder(static_cast<U*>(src_storage));
+            U* dst = ::new (dst_storage) U(std::move(*src));
+            src->~U();
+            return dst;
+        },
+        true
+    };
+
+    template <typename U>
+    inline constexpr SmallObjectOperations heap_object_operations {
+        [](void* storage) noexcept { delete static_cast<U*>(*std::launder(static_cast<void**>(storage))); },
+        [](void* dst_storage, void* src_storage) noexcept -> void* {
+            return *::new (dst_storage) void*(*std::launder(static_cast<void**>(src_storage)));
+        },
+        false
+    };
+
+    /*
+    * unique_ptr with Small Object Optimization.
+    * The managed object may be any type U derived from T (e.g. small_unique_ptr<Handler> holding a TcpHandler).
+    * U is constructed inside the inline buffer when it fits and is nothrow movable, otherwise on the heap.
+    *
+    * As only the constructor knows U, every object carries a pointer to a static table of type erased operations
+    * (destroy + relocate) generated for U. Moving a small_unique_ptr relocates the object itself into the new buffer
+    * through that table, so derived objects are moved as a whole instead of being sliced to T.
+    */
     template <typename T, std::size_t BufferSize = 64>
     class small_unique_ptr {
     public:
         using element_type = T;
         using pointer = T*;
 
+        // objects of type U are stored inline if this is true
+        template <typename U>
+        static constexpr bool fits_inline = fits_small_buffer<U, BufferSize>;
+
     private:
+        template <typename U, std::size_t N>
+        friend class small_unique_ptr;
+
         pointer ptr_;
-        alignas(std::max_align_t) std::byte buffer_[BufferSize];
-        bool constructed_inline_;
+        const SmallObjectOperations* operations_;
+        alignas(std::max_align_t) std::byte buffer_[BufferSize < sizeof(void*) ? sizeof(void*) : BufferSize];
 
     public:
         constexpr small_unique_ptr() noexcept
             : ptr_ { nullptr }
-            , constructed_inline_ { false }
+            , operations_ { nullptr }
+        { }
+
+        constexpr small_unique_ptr(std::nullptr_t) noexcept
+            : small_unique_ptr()
         { }
 
+        // constructs a T from args
         template <typename... Args>
-        constexpr explicit small_unique_ptr(Args&&... args) noexcept {
-            if (sizeof(element_type) <= BufferSize && alignof(element_type) <= alignof(std::max_align_t)) {
-                new (static_cast<void*>(&buffer_)) T(std::forward<Args>(args)...);
-                ptr_ = std::launder(reinterpret_cast<pointer>(&buffer_));
-                constructed_inline_ = true;
+        requires std::constructible_from<T, Args...>
+        explicit small_unique_ptr(Args&&... args)
+            : small_unique_ptr(std::in_place_type<T>, std::forward<Args>(args)...)
+        { }
+
+        // constructs a U (T or a type derived from T) from args
+        template <typename U, typename... Args>
+        requires std::convertible_to<U*, T*> && std::constructible_from<U, Args...>
+        explicit small_unique_ptr(std::in_place_type_t<U>, Args&&... args)
+            : small_unique_ptr()
+        {
+            if constexpr (fits_inline<U>) {
+                ptr_ = ::new (static_cast<void*>(buffer_)) U(std::forward<Args>(args)...);
+                operations_ = &inline_object_operations<U>;
             } else {
-                ptr_ = new T(std::forward<Args>(args)...);
-                constructed_inline_ = false;
+                U* object = new U(std::forward<Args>(args)...);
+                ::new (static_cast<void*>(buffer_)) void*(object);
+                ptr_ = object;
+                operations_ = &heap_object_operations<U>;
             }
         }
 
@@ -274,18 +355,29 @@ namespace CustomSTL {
             reset();
         }
 
-        constexpr small_unique_ptr(small_unique_ptr&& other) noexcept {
+        small_unique_ptr(small_unique_ptr&& other) noexcept
+            : small_unique_ptr()
+        {
             move_from(other);
         }
-        
-        constexpr small_unique_ptr& operator=(small_unique_ptr&& other) noexcept {
+
+        // Converting move from a small_unique_ptr<U> of the same buffer size, e.g. small_unique_ptr<Derived> to <Base>
+        template <typename U>
+        requires (!std::same_as<U, T>) && std::convertible_to<U*, T*>
+        small_unique_ptr(small_unique_ptr<U, BufferSize>&& other) noexcept
+            : small_unique_ptr()
+        {
+            move_from(other);
+        }
+
+        small_unique_ptr& operator=(small_unique_ptr&& other) noexcept {
             if (this == &other) {
                 return *this;
             }
 
             reset();
             move_from(other);
-            
+
             return *this;
         }
 
@@ -295,23 +387,29 @@ namespace CustomSTL {
 
         void reset() noexcept {
             if (ptr_) {
-                if (constructed_inline_) {
-                    ptr_->~T();
-                } else {
-                    delete ptr_;
-                }
+                operations_->destroy(buffer_);
                 ptr_ = nullptr;
-                constructed_inline_ = false;
+                operations_ = nullptr;
             }
         }
 
+        void swap(small_unique_ptr& other) noexcept {
+            small_unique_ptr tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+        constexpr bool is_constructed_inline() const noexcept { return operations_ && operations_->is_inline; }
+
+        static constexpr std::size_t buffer_size() noexcept { return BufferSize; }
+
         constexpr pointer get() noexcept { return ptr_; }
 
-        constexpr const pointer get() const noexcept { return ptr_; }
-        
+        constexpr pointer get() const noexcept { return ptr_; }
+
         constexpr pointer operator->() noexcept { return ptr_; }
 
-        constexpr const pointer operator->() const noexcept { return ptr_; }
+        constexpr pointer operator->() const noexcept { return ptr_; }
 
         constexpr T& operator*() noexcept { return *ptr_; }
 
@@ -320,18 +418,34 @@ namespace CustomSTL {
         constexpr explicit operator bool() const noexcept { return ptr_; }
 
     private:
-        constexpr void move_from(small_unique_ptr& other) noexcept {
-            constructed_inline_ = other.constructed_inline_;
-            if (constructed_inline_) {
-                new (static_cast<void*>(&buffer_)) T(std::move(other.get()));
-                ptr_ = std::launder(reinterpret_cast<T*>(&buffer_));
-                other.reset();
-            } else {
-                ptr_ = std::exchange(other.ptr_, nullptr);
+        // Relocates the object owned by other (of any type U convertible to T) into our buffer.
+        // ptr_ may not point to the start of the object (e.g. multiple inheritance), so the offset of the T subobject
+        // is preserved when the object moves to a new address.
+        template <typename U>
+        void move_from(small_unique_ptr<U, BufferSize>& other) noexcept {
+            if (!other.ptr_) {
+                return;
             }
+
+            T* converted = other.ptr_;
+            void* src_object = other.operations_->is_inline ? static_cast<void*>(other.buffer_)
+                                                            : *std::launder(reinterpret_cast<void**>(other.buffer_));
+            std::ptrdiff_t offset = reinterpret_cast<std::byte*>(converted) - static_cast<std::byte*>(src_object);
+
+            void* dst_object = other.operations_->relocate(buffer_, other.buffer_);
+            ptr_ = std::launder(reinterpret_cast<T*>(static_cast<std::byte*>(dst_object) + offset));
+            operations_ = other.operations_;
+
+            other.ptr_ = nullptr;
+            other.operations_ = nullptr;
         }
     };
 
+    template <typename T, typename U = T, std::size_t BufferSize = 64, typename... Args>
+    small_unique_ptr<T, BufferSize> make_small_unique(Args&&... args) {
+        return small_unique_ptr<T, BufferSize>(std::in_place_type<U>, std::forward<Args>(args)...);
+    }
+
     template <typename T, typename... Args>
     constexpr unique_ptr<T> make_unique(Args&&... args) {
         return unique_ptr<T>(new T(std::forward<Args>(args)...));
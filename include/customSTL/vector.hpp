@@ -90,7 +90,7 @@ private:
             T* new_data = static_cast<T*>(std::malloc(new_capacity * sizeof(T)));
             if (!new_data) throw std::bad_alloc();
 
-            for (size_t i = 0; i < old_capacity; ++i) {
+            for (ptrdiff_t i = 0; i < old_capacity; ++i) {
                 new (new_data + i) T(std::move_if_noexcept(data_[i]));
                 data_[i].~T();
             }
@@ -0,0 +1,101 @@
+#ifndef CUSTOM_STL_WEAK_CACHE_HPP
+#define CUSTOM_STL_WEAK_CACHE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "lock_guard.hpp"
+#include "shared_ptr.hpp"
+#include "weak_ptr.hpp"
+
+namespace CustomSTL {
+
+    // Deduplicating cache of shared immutable objects (e.g. instrument definitions).
+    // The cache only holds weak_ptr objects, so an entry never keeps its object alive: once the last user drops its
+    // shared_ptr the object is destroyed, and the expired entry is swept out the next time the map grows too much.
+    template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class weak_cache {
+    private:
+        std::unordered_map<Key, weak_ptr<const T>, Hash, KeyEqual> entries_;
+        size_t sweep_threshold_ { 64 };
+        mutable std::mutex mutex_;
+
+    public:
+        weak_cache() = default;
+
+        weak_cache(const weak_cache&) = delete;
+        weak_cache& operator=(const weak_cache&) = delete;
+
+        // Returns the live object for key, or nullptr if there is none
+        shared_ptr<const T> find(const Key& key) const {
+            CustomSTL::lock_guard<std::mutex> lock(mutex_);
+
+            auto it = entries_.find(key);
+            return it == entries_.end() ? shared_ptr<const T>() : it->second.lock();
+        }
+
+        // Returns the live object for key, or creates it with factory() (which must return shared_ptr<T>)
+        // Every caller asking for the same key while the object is alive shares the same instance.
+        // factory() runs without the lock held, so it may use the cache itself and does not stall other lookups;
+        // if two callers race on a missing key both build an object, but only the first one inserted is kept.
+        template <typename Factory>
+        shared_ptr<const T> get_or_create(const Key& key, Factory&& factory) {
+            if (shared_ptr<const T> existing = find(key)) {
+                return existing;
+            }
+
+            // declared before the lock, so a discarded object is destroyed after the mutex is released
+            shared_ptr<const T> created = std::forward<Factory>(factory)();
+
+            CustomSTL::lock_guard<std::mutex> lock(mutex_);
+
+            auto [it, inserted] = entries_.try_emplace(key, created);
+            if (inserted) {
+                maybe_sweep();
+            } else if (shared_ptr<const T> existing = it->second.lock()) {
+                return existing;
+            } else {
+                it->second = created;
+            }
+
+            return created;
+        }
+
+        // Convenience overload constructing the object with make_shared<T>(args...)
+        template <typename... Args>
+        shared_ptr<const T> get_or_emplace(const Key& key, Args&&... args) {
+            return get_or_create(key, [&] { return CustomSTL::make_shared<T>(std::forward<Args>(args)...); });
+        }
+
+        // Removes every entry whose object has been destroyed
+        void purge_expired() {
+            CustomSTL::lock_guard<std::mutex> lock(mutex_);
+            sweep();
+        }
+
+        // Number of entries, including expired ones that have not been swept yet
+        size_t size() const {
+            CustomSTL::lock_guard<std::mutex> lock(mutex_);
+            return entries_.size();
+        }
+
+    private:
+        // Sweeping is amortized: we only sweep once the map doubled since the last sweep, so the cost is O(1) per insert
+        void maybe_sweep() {
+            if (entries_.size() >= sweep_threshold_) {
+                sweep();
+                sweep_threshold_ = std::max(size_t { 64 }, entries_.size() * 2);
+            }
+        }
+
+        void sweep() {
+            std::erase_if(entries_, [](const auto& entry) { return entry.second.expired(); });
+        }
+    };
+}
+
+#endif
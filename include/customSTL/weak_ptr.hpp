@@ -1,47 +1,117 @@
 #ifndef CUSTOM_STL_WEAK_PTR_HPP
 #define CUSTOM_STL_WEAK_PTR_HPP
 
+#include <cstddef>
+#include <utility>
+
 #include "shared_ptr.hpp"
 
 namespace CustomSTL {
-    
-    template <typename T>
+
+    // Non owning reference to an object managed by shared_ptr.
+    // Holds a weak reference on the control block, which keeps the block (but not the object) alive.
+    template <typename T, typename Policy = atomic_count_policy>
     class weak_ptr {
+    public:
+        using element_type = T;
+        using control_block = ControlBlock<Policy>;
+
     private:
-        CustomSTL::ControlBlock* ptr_;
+        T* ptr_;
+        control_block* control_ptr_;
+
+        template <typename Y, typename P>
+        friend class weak_ptr;
 
     public:
         constexpr weak_ptr() noexcept
             : ptr_ { nullptr }
+            , control_ptr_ { nullptr }
         { }
 
-        constexpr weak_ptr(const weak_ptr& other) noexcept
+        template <typename Y>
+        requires PointerCompatible<Y, T>
+        weak_ptr(const shared_ptr<Y, Policy>& other) noexcept
+            : ptr_ { other.ptr_ }
+            , control_ptr_ { other.control_ptr_ }
+        {
+            if (control_ptr_ != nullptr) {
+                control_ptr_->add_weak();
+            }
+        }
+
+        weak_ptr(const weak_ptr& other) noexcept
             : ptr_ { other.ptr_ }
-        { 
-            if (ptr_ != nullptr) {
-                ptr_->add_weak();
+            , control_ptr_ { other.control_ptr_ }
+        {
+            if (control_ptr_ != nullptr) {
+                control_ptr_->add_weak();
             }
         }
 
-        constexpr weak_ptr(weak_ptr&& other) noexcept
+        template <typename Y>
+        requires PointerCompatible<Y, T>
+        weak_ptr(const weak_ptr<Y, Policy>& other) noexcept
+            : weak_ptr(other.lock())
+        { }
+
+        weak_ptr(weak_ptr&& other) noexcept
             : ptr_ { std::exchange(other.ptr_, nullptr) }
+            , control_ptr_ { std::exchange(other.control_ptr_, nullptr) }
         { }
 
         ~weak_ptr() noexcept {
-            if (ptr_) {
-                ptr_->release_weak();
+            if (control_ptr_) {
+                control_ptr_->release_weak();
             }
         }
 
-        constexpr weak_ptr& operator=(const weak_ptr& other) noexcept {
-            if (&other == this) {
+        weak_ptr& operator=(const weak_ptr& other) noexcept {
+            weak_ptr(other).swap(*this);
+            return *this;
+        }
 
-            }
+        template <typename Y>
+        requires PointerCompatible<Y, T>
+        weak_ptr& operator=(const shared_ptr<Y, Policy>& other) noexcept {
+            weak_ptr(other).swap(*this);
+            return *this;
+        }
+
+        weak_ptr& operator=(weak_ptr&& other) noexcept {
+            weak_ptr(std::move(other)).swap(*this);
+            return *this;
         }
 
+        void reset() noexcept {
+            weak_ptr().swap(*this);
+        }
+
+        void swap(weak_ptr& other) noexcept {
+            std::swap(ptr_, other.ptr_);
+            std::swap(control_ptr_, other.control_ptr_);
+        }
+
+        long use_count() const noexcept { return control_ptr_ ? control_ptr_->get_strong_count() : 0; }
+
+        bool expired() const noexcept { return use_count() == 0; }
+
+        // Returns a shared_ptr owning the object, or an empty shared_ptr if it has already been destroyed.
+        // The strong count is only incremented with a CAS while it is non zero, so we can never resurrect an object
+        // that another thread is in the middle of destroying.
+        shared_ptr<T, Policy> lock() const noexcept {
+            if (control_ptr_ != nullptr && control_ptr_->try_add_strong()) {
+                return shared_ptr<T, Policy>(ptr_, control_ptr_);
+            }
+            return shared_ptr<T, Policy>();
+        }
 
+        template <typename Y>
+        bool owner_before(const weak_ptr<Y, Policy>& other) const noexcept { return control_ptr_ < other.control_ptr_; }
 
+        template <typename Y>
+        bool owner_before(const shared_ptr<Y, Policy>& other) const noexcept { return control_ptr_ < other.control_ptr_; }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -5,6 +5,7 @@
 #include <fcntl.h>
 #include <iostream>
 #include <netdb.h>
+#include <netinet/in.h>
 #include <string>
 #include <stdexcept>
 #include <sys/socket.h>
@@ -16,7 +17,9 @@ namespace network {
 
 class TCPSocket {
 public:
-    TCPSocket(const std::string& port_number) {
+    // With reuse_port, several sockets (one per reactor thread) can bind the same port and the kernel load balances
+    // incoming connections between them (SO_REUSEPORT)
+    TCPSocket(const std::string& port_number, bool reuse_port = false) {
         struct addrinfo hints;
         struct addrinfo *socket_info = nullptr;
 
@@ -41,6 +44,12 @@ public:
             freeaddrinfo(socket_info);
             throw std::runtime_error("Unable to set SO_REUSEADDR");
         }
+
+        if (reuse_port && setsockopt(socket_fd, SOL_SOCKET, SO_REUSEPORT, &option, sizeof(option)) == -1) {
+            close(socket_fd);
+            freeaddrinfo(socket_info);
+            throw std::runtime_error("Unable to set SO_REUSEPORT");
+        }
         
         if (int rc = bind(socket_fd, socket_info->ai_addr, socket_info->ai_addrlen); rc == -1) {
             close(socket_fd);
@@ -114,6 +123,20 @@ public:
 
     int get_fd() { return socket_fd; }
 
+    // the port the socket is bound to, useful when binding port "0" to let the kernel pick one
+    std::string get_port() {
+        struct sockaddr_storage address;
+        socklen_t address_len = sizeof(struct sockaddr_storage);
+        if (getsockname(socket_fd, (struct sockaddr *)&address, &address_len) == -1) {
+            throw std::runtime_error("Unable to get socket's address");
+        }
+
+        if (address.ss_family == AF_INET6) {
+            return std::to_string(ntohs(((struct sockaddr_in6 *)&address)->sin6_port));
+        }
+        return std::to_string(ntohs(((struct sockaddr_in *)&address)->sin_port));
+    }
+
 private:
     int socket_fd = -1;
 };
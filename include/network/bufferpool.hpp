@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "customSTL/object_pool.hpp"
+
+namespace network {
+
+/*
+* Fixed size I/O buffers for the connections of one reactor, not thread safe.
+* Blocks are carved out of slabs (CustomSTL::SlotPool) of blocks_per_slab blocks. The pool grows a slab at a time
+* when every block is in use, and frees a slab once all of its blocks are back (keeping one empty slab around so that
+* a connection count hovering around a slab boundary does not allocate and free a slab every time), so the memory
+* follows the number of buffers in use instead of its peak.
+*/
+class BufferPool {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 16384;
+
+    // blocks_per_slab * block_size should be above the malloc mmap threshold (128KB by default), so that freeing
+    // a slab actually returns its memory to the OS
+    explicit BufferPool(size_t block_size = DEFAULT_BLOCK_SIZE, size_t blocks_per_slab = 64)
+        : block_size_ { block_size }
+        , blocks_per_slab_ { std::max(blocks_per_slab, size_t { 1 }) }
+    { }
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Partially used slabs are filled before the empty spare is touched, so that blocks stay packed in as few slabs as
+    // possible and the others can empty out and be freed
+    char* allocate() {
+        if (available_.empty()) {
+            available_.push_back(empty_slab_ != nullptr ? std::exchange(empty_slab_, nullptr) : add_slab());
+        }
+
+        Slab* slab = available_.back();
+        if (++slab->in_use == blocks_per_slab_) {
+            // a full slab leaves the list, and comes back once one of its blocks is freed
+            available_.pop_back();
+        }
+        ++blocks_in_use_;
+        return static_cast<char*>(slab->slots->allocate());
+    }
+
+    void deallocate(char* block) noexcept {
+        auto it = std::prev(slabs_.upper_bound(block));
+        Slab& slab = it->second;
+        slab.slots->deallocate(block);
+        --blocks_in_use_;
+
+        if (slab.in_use-- == blocks_per_slab_) {
+            available_.push_back(&slab);
+        }
+        if (slab.in_use == 0) {
+            std::erase(available_, &slab);
+            if (empty_slab_ == nullptr) {
+                empty_slab_ = &slab;
+            } else {
+                slabs_.erase(it);
+            }
+        }
+    }
+
+    size_t block_size() const noexcept { return block_size_; }
+    size_t blocks_in_use() const noexcept { return blocks_in_use_; }
+    size_t slab_count() const noexcept { return slabs_.size(); }
+    size_t available_slab_count() const noexcept { return available_.size(); }
+
+private:
+    struct Slab {
+        std::unique_ptr<CustomSTL::SlotPool> slots;
+        size_t in_use = 0;
+    };
+
+    Slab* add_slab() {
+        auto slots = std::make_unique<CustomSTL::SlotPool>(block_size_, alignof(std::max_align_t), blocks_per_slab_);
+        const char* key = static_cast<const char*>(slots->storage());
+        Slab& slab = slabs_[key];
+        slab.slots = std::move(slots);
+        return &slab;
+    }
+
+    size_t block_size_;
+    size_t blocks_per_slab_;
+    size_t blocks_in_use_ = 0;
+    // slabs by start address, so that a block can be traced back to its slab (map nodes never move)
+    std::map<const char*, Slab, std::less<>> slabs_;
+    // partially used slabs (at least one free block and one in use), each listed once
+    std::vector<Slab*> available_;
+    Slab* empty_slab_ = nullptr; // the spare, not in available_
+};
+
+}
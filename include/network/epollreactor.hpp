@@ -1,42 +1,118 @@
 #pragma once
 
-#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <concepts>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <fcntl.h>
+#include <immintrin.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
 #include <stdexcept>
 #include <unistd.h>
 #include <utility>
 #include <vector>
 
 #include "TCPSocket.hpp"
+#include "bufferpool.hpp"
+#include "mirroredbuffer.hpp"
+#include "outputbuffer.hpp"
+#include "reactormetrics.hpp"
+#include "timerwheel.hpp"
 
 namespace network {
 
+// A handler that replies through the connection's OutputBuffer instead of writing to the socket itself
 template <typename T>
-concept HasOnDataMethod = requires(T obj, int fd, void* buf, int bytes) { 
+concept HasBufferedOnDataMethod = requires(T obj, int fd, void* buf, int bytes, OutputBuffer& out) {
+    { obj.on_data(fd, buf, bytes, out) } -> std::same_as<int>;
+};
+
+template <typename T>
+concept HasOnDataMethod = HasBufferedOnDataMethod<T> || requires(T obj, int fd, void* buf, int bytes) { 
     { obj.on_data(fd, buf, bytes) } -> std::same_as<int>;
 };
 
 template <HasOnDataMethod MessageHandler>
 class EpollReactor {
 private:
-    // ConnectionState struct is used to have a buffer for each file descriptor in the interest list
-    // This ensures that we do not keep creating local temporary buffers
+    // ConnectionState is indexed by file descriptor, the table grows with the highest fd in use.
+    // The input buffer is a mirrored ring taken from the reactor's MirroredBufferPool when data arrives and given back
+    // as soon as every byte was consumed, so an idle connection only costs this struct. A message that does not fit
+    // moves to a ring twice as large, as many times as needed up to MAX_MESSAGE_SIZE.
     struct ConnectionState {
-        std::array<char, 8192> data{};
-        size_t offset{};
+        std::unique_ptr<MirroredBuffer> input;
+        OutputBuffer output;
+        bool flush_pending{}; // output was queued during the current batch of events
+        bool writable_armed{}; // EPOLLOUT is registered because the socket buffer was full
+        bool accepted{}; // by run(), rather than added with add_socket
+        bool open{}; // registered with epoll and not closed yet
+        TimerWheel::TimerId idle_timer; // with Options::idle_timeout
+        TimerWheel::Clock::time_point last_active; // last time data was received
     };
 
 public:
-    EpollReactor(MessageHandler& handler) 
-        : epoll_fd_ { epoll_create1(EPOLL_CLOEXEC) }, handler_ { handler } {
+    struct Options {
+        // Low latency mode: after handling events, poll with a zero timeout for this long before blocking in
+        // epoll_wait again, so that a message arriving meanwhile is handled without a wakeup through the scheduler.
+        // Burns the core while idle, only for reactors pinned to dedicated cores.
+        std::chrono::microseconds busy_poll_budget { 0 };
+        // SO_BUSY_POLL on every client socket: a blocking epoll_wait polls the NIC queue for this long before
+        // sleeping. Best effort, values above net.core.busy_read need CAP_NET_ADMIN.
+        int socket_busy_poll_us = 0;
+        bool prefer_busy_poll = false; // SO_PREFER_BUSY_POLL, with socket_busy_poll_us
+        // The number of events fetched per epoll_wait adapts to the load between these two bounds
+        int min_events = 64;
+        int max_events = 4096;
+        // Accepted connections that receive nothing for this long are closed, zero keeps them open
+        std::chrono::milliseconds idle_timeout { 0 };
+        std::chrono::microseconds timer_resolution { 1000 };
+        // High-water mark of a connection's queued output: a connection whose peer does not read its replies is
+        // closed once more than this many bytes are left unsent after a flush, zero never closes it
+        size_t max_queued_output = 64 * 1024 * 1024;
+    };
+
+    EpollReactor(MessageHandler& handler, const Options& options = {})
+        : handler_ { handler }
+        , options_ { options }
+        , timers_ { std::make_unique<TimerWheel>(options.timer_resolution) }
+        , epoll_fd_ { epoll_create1(EPOLL_CLOEXEC) }
+    {
+        if (options_.min_events < 1 || options_.max_events < options_.min_events) {
+            if (epoll_fd_ != -1) {
+                close(epoll_fd_);
+            }
+            throw std::invalid_argument("EpollReactor needs 1 <= min_events <= max_events.");
+        }
+        events_.resize(options_.max_events);
+        batch_size_ = options_.min_events;
+
         if (epoll_fd_ == -1) {
             throw std::runtime_error("Unable to create epoll instance.");
         }
+
+        // stop() writes to this eventfd to wake up a blocked epoll_wait, it stays level triggered until run() returns
+        wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wakeup_fd_;
+        if (wakeup_fd_ == -1 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) == -1) {
+            if (wakeup_fd_ != -1) {
+                close(wakeup_fd_);
+            }
+            close(epoll_fd_);
+            throw std::runtime_error("Unable to create wakeup eventfd.");
+        }
     }
 
     ~EpollReactor() {
+        if (wakeup_fd_ != -1) {
+            close(wakeup_fd_);
+        }
         if (epoll_fd_ != -1) {
             close(epoll_fd_);
         }
@@ -46,55 +122,56 @@ public:
     EpollReactor(const EpollReactor&) = delete;
     EpollReactor& operator=(const EpollReactor&) = delete;
 
-    // allow move semantics
+    // moving is only allowed while the reactor is not running and has no timers, their callbacks point to it
     EpollReactor(EpollReactor&& other)
-        : epoll_fd_ { std::exchange(other.epoll_fd_, -1) }
+        : pool_ { std::move(other.pool_) }
+        , inputs_ { std::move(other.inputs_) }
+        , connections_ { std::move(other.connections_) }
+        , handler_ { other.handler_ }
+        , options_ { other.options_ }
+        , timers_ { std::move(other.timers_) }
+        , epoll_fd_ { std::exchange(other.epoll_fd_, -1) }
+        , wakeup_fd_ { std::exchange(other.wakeup_fd_, -1) }
+        , pending_flushes_ { std::move(other.pending_flushes_) }
+        , events_ { std::move(other.events_) }
+        , batch_size_ { other.batch_size_ }
     { }
 
-    EpollReactor& operator=(EpollReactor&& other) {
-        if (this == &other) {
-            return *this;
-        }
-
-        if (epoll_fd_ != -1) {
-            close(epoll_fd_);
-        }
-
-        epoll_fd_ = std::exchange(other.epoll_fd_, -1);
-        return *this;
-    }
+    EpollReactor& operator=(EpollReactor&&) = delete;
 
     void add_socket(int fd) {
         if (fd == -1) [[unlikely]] { 
             throw std::runtime_error("File descriptor passed in is invalid.");
         }
-
-        struct epoll_event event{};
-        // edge triggered for receiving inputs
-        event.events = EPOLLIN | EPOLLET;
-        event.data.fd = fd;
-
-        int rc = epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
-        if (rc == -1) {
+        if (!register_socket(fd)) {
             throw std::runtime_error("Unable to add file descriptor");
         }
     }
 
+    // Runs the event loop on the calling thread until stop() is called
     void run(TCPSocket& server_socket) {
-        while (true) {
-
-            struct epoll_event events[MAX_EVENTS];
-            int ready_count = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1); // -1 to block until an event occurs
+        while (!stopped_.load(std::memory_order_acquire)) {
 
+            int ready_count = wait_for_events();
             if (ready_count == -1) {
                 if (errno == EINTR) {
                     continue;
                 }
                 throw std::runtime_error("Unexpected error occurred during epoll_wait.");
             }
-    
+            adapt_batch_size(ready_count);
+            metrics_.waited(ready_count);
+            uint64_t iteration_start = metrics_.timestamp();
+            // read once per iteration: the time data was received at, and the time timers advance to
+            loop_time_ = TimerWheel::Clock::now();
+
+            struct epoll_event* events = events_.data();
             for (int i = 0; i < ready_count; ++i) {
                 int fd = events[i].data.fd;
+                if (fd == wakeup_fd_) {
+                    // stop() was called, checked by the loop condition
+                    continue;
+                }
                 // a new client is trying to connect, accept them if possible
                 if (server_socket.get_fd() == fd) {
                     while (true) {
@@ -108,51 +185,309 @@ public:
                             close(client_fd);
                             continue;
                         };
-                        add_socket(client_fd);
+                        // e.g. ENOMEM from epoll_ctl: only this client is turned away, the others are still served
+                        if (!register_socket(client_fd)) {
+                            close(client_fd);
+                            continue;
+                        }
+                        connections_[client_fd].accepted = true;
+                        metrics_.accepted();
+                        if (options_.idle_timeout.count() > 0) {
+                            watch_idle(client_fd);
+                        }
                     }
                 } else {
-                    // a client socket woke up instead
-                    // Note: make sure to read all of the data as we are using edge triggered. See man page for details
-                    while (true) {
-                        ConnectionState& buffer = fd_buffers[fd];
-                        int bytes_received = recv(fd, &buffer.data[buffer.offset], 8192 - buffer.offset, 0);
-                        if (bytes_received == -1) {
-                            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                                // no more data left in the buffer
-                                break;
-                            }
-                            // unexpected error, close the client file descriptor
-                            buffer.offset = 0;
-                            close(fd);
-                            break;
-                        } else if (bytes_received == 0) {
-                            // client disconnected
-                            buffer.offset = 0; // reset buffer for next file descriptor use
-                            close(fd);
-                            break;
-                        } else {
-                            // process data
-                            buffer.offset += bytes_received;
-                            int bytes_consumed = handler_.on_data(fd, buffer.data.data(), buffer.offset);
-                            std::memmove(buffer.data.data(), &buffer.data[bytes_consumed], buffer.offset - bytes_consumed);
-                            buffer.offset = buffer.offset - bytes_consumed;
-                        }
+                    if ((events[i].events & EPOLLOUT) && !flush(fd)) {
+                        continue;
+                    }
+                    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                        receive(fd);
                     }
                 }
             }
+
+            // timers that came due run as one batch, replies they queue go out with the others
+            timers_->advance(loop_time_);
+
+            // responses queued while handling this batch go out now, one syscall per connection
+            flush_pending();
+            metrics_.iteration_done(iteration_start);
+        }
+    }
+
+    // Queues data on the connection's output buffer, it is sent once the current batch of events is handled.
+    // Must be called from the reactor's thread (e.g. from a handler). Data for an fd that is not an open connection of
+    // this reactor (e.g. one that was closed meanwhile) is dropped.
+    void send(int fd, const void* data, size_t size) {
+        if (fd < 0 || static_cast<size_t>(fd) >= connections_.size() || !connections_[fd].open) [[unlikely]] {
+            return;
         }
+        ConnectionState& connection = connections_[fd];
+        connection.output.append(data, size);
+        mark_pending(fd, connection);
+    }
+
+    // Makes run() return after the events it is currently processing, can be called from any thread
+    void stop() {
+        stopped_.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t rc = write(wakeup_fd_, &one, sizeof(one));
     }
 
     int get_epollfd() { return epoll_fd_; }
 
+    // Counters of the reactor's own behaviour, readable from any thread (all zero without CUSTOMSTL_REACTOR_METRICS)
+    ReactorStats metrics() const { return metrics_.snapshot(); }
+
+    // Timers run on the reactor's thread between batches of events, and must only be used from it (e.g. from a handler)
+    TimerWheel& timers() { return *timers_; }
+
+    // current maximum number of events fetched per epoll_wait
+    int event_batch_size() const { return batch_size_; }
+
+    // buffers currently taken by connections, for monitoring memory use
+    const BufferPool& buffer_pool() const { return *pool_; }
+    const MirroredBufferPool& input_buffers() const { return *inputs_; }
+
 private:
-    std::vector<ConnectionState> fd_buffers = std::vector<ConnectionState>(MAX_CONNECTIONS);
+    // Gives fd a fresh connection state and registers it with epoll, returns false if epoll_ctl failed
+    bool register_socket(int fd) {
+        if (static_cast<size_t>(fd) >= connections_.size()) {
+            connections_.resize(std::max(static_cast<size_t>(fd) + 1, connections_.size() * 2));
+        }
+        // a fresh connection state, in case the fd was used by a connection that was not closed through the reactor
+        inputs_->release(std::move(connections_[fd].input));
+        timers_->cancel(connections_[fd].idle_timer);
+        connections_[fd] = ConnectionState {};
+        connections_[fd].output = OutputBuffer(pool_.get());
+        if (options_.socket_busy_poll_us > 0) {
+            set_busy_poll(fd);
+        }
+
+        struct epoll_event event{};
+        // edge triggered for receiving inputs
+        event.events = EPOLLIN | EPOLLET;
+        event.data.fd = fd;
+
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1) {
+            return false;
+        }
+        connections_[fd].open = true;
+        return true;
+    }
+
+    // Blocks until events are ready or the next timer may be due, after spinning with a zero timeout for the busy
+    // poll budget if there is one
+    int wait_for_events() {
+        if (options_.busy_poll_budget.count() > 0) {
+            auto deadline = std::chrono::steady_clock::now() + options_.busy_poll_budget;
+            do {
+                int ready_count = epoll_wait(epoll_fd_, events_.data(), batch_size_, 0);
+                if (ready_count != 0) {
+                    return ready_count;
+                }
+                _mm_pause();
+            } while (std::chrono::steady_clock::now() < deadline && !stopped_.load(std::memory_order_relaxed));
+        }
+        return epoll_wait(epoll_fd_, events_.data(), batch_size_, timeout_ms());
+    }
+
+    // -1 blocks until an event occurs when there are no timers
+    int timeout_ms() const {
+        if (timers_->empty()) {
+            return -1;
+        }
+        auto due = timers_->now() + timers_->next_timeout();
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(due - TimerWheel::Clock::now());
+        return static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(remaining.count(), 0, std::numeric_limits<int>::max()));
+    }
+
+    // Idle connections are found lazily: receiving only records the time, and the timer checks it when it fires,
+    // closing the connection or sleeping for the rest of the timeout. A busy connection costs no timer operation.
+    void watch_idle(int fd) {
+        ConnectionState& connection = connections_[fd];
+        connection.last_active = loop_time_;
+        connection.idle_timer = timers_->schedule(options_.idle_timeout, [this, fd] { reap_if_idle(fd); });
+    }
+
+    void reap_if_idle(int fd) {
+        ConnectionState& connection = connections_[fd];
+        auto idle = loop_time_ - connection.last_active;
+        if (idle >= options_.idle_timeout) {
+            close_connection(fd);
+        } else {
+            timers_->reschedule(connection.idle_timer, options_.idle_timeout - idle);
+        }
+    }
+
+    // A full batch means more events were probably left in the ready list, so the next wait fetches twice as many;
+    // the batch shrinks back when it stays mostly empty. Fetching fewer events per call keeps the array in cache.
+    void adapt_batch_size(int ready_count) {
+        if (ready_count == batch_size_) {
+            batch_size_ = std::min(batch_size_ * 2, options_.max_events);
+        } else if (ready_count < batch_size_ / 4) {
+            batch_size_ = std::max(batch_size_ / 2, options_.min_events);
+        }
+    }
+
+    void set_busy_poll(int fd) {
+        // failures are ignored: busy polling only lowers latency, and raising it needs privileges we may not have
+        int busy_poll = options_.socket_busy_poll_us;
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll));
+        if (options_.prefer_busy_poll) {
+            int prefer = 1;
+            setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer));
+        }
+    }
+
+    void receive(int fd) {
+        // Note: make sure to read all of the data as we are using edge triggered. See man page for details
+        while (true) {
+            // not kept across on_data, a handler adding sockets may grow the table
+            ConnectionState& buffer = connections_[fd];
+            if ((!buffer.input || buffer.input->free_space() == 0) && !reserve_input(buffer)) {
+                // the message is larger than MAX_MESSAGE_SIZE, or no ring could be mapped for it
+                close_connection(fd);
+                return;
+            }
+
+            MirroredBuffer& input = *buffer.input;
+            int bytes_received = recv(fd, input.space(), input.free_space(), 0);
+            if (bytes_received == -1) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    // no more data left in the buffer
+                    metrics_.would_block();
+                    if (input.empty()) {
+                        inputs_->release(std::move(buffer.input));
+                    }
+                    break;
+                }
+                // unexpected error, close the client file descriptor
+                close_connection(fd);
+                break;
+            } else if (bytes_received == 0) {
+                // client disconnected
+                close_connection(fd);
+                break;
+            } else {
+                // process data, the unconsumed bytes stay where they are: the ring's free space follows them
+                input.commit(bytes_received);
+                buffer.last_active = loop_time_;
+                metrics_.received(bytes_received);
+                uint64_t handler_start = metrics_.timestamp();
+                int bytes_consumed;
+                if constexpr (HasBufferedOnDataMethod<MessageHandler>) {
+                    bytes_consumed = handler_.on_data(fd, input.data(), input.size(), buffer.output);
+                } else {
+                    bytes_consumed = handler_.on_data(fd, input.data(), input.size());
+                }
+                metrics_.handled(handler_start);
+                input.consume(bytes_consumed);
+
+                ConnectionState& connection = connections_[fd];
+                if (!connection.output.empty()) {
+                    mark_pending(fd, connection);
+                }
+            }
+        }
+    }
+
+    // Makes room for more input: a ring from the pool for a connection without one, otherwise a ring twice as large.
+    // Mapping a ring fails once the process runs out of memory mappings (each ring takes two, see vm.max_map_count):
+    // only the connection that needed it is closed then, the reactor keeps serving the others.
+    bool reserve_input(ConnectionState& connection) {
+        if (connection.input && connection.input->capacity() >= MAX_MESSAGE_SIZE) {
+            return false;
+        }
+        try {
+            connection.input = connection.input ? inputs_->grow(std::move(connection.input)) : inputs_->acquire();
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+
+    void mark_pending(int fd, ConnectionState& connection) {
+        if (!connection.flush_pending) {
+            connection.flush_pending = true;
+            pending_flushes_.push_back(fd);
+        }
+    }
+
+    void flush_pending() {
+        for (int fd : pending_flushes_) {
+            ConnectionState& connection = connections_[fd];
+            if (connection.flush_pending) {
+                connection.flush_pending = false;
+                flush(fd);
+            }
+        }
+        pending_flushes_.clear();
+    }
+
+    // Writes as much queued output as the socket takes, returns false if the connection had to be closed.
+    // EPOLLOUT is only armed while the socket buffer is full, so a connection that keeps up with its output never
+    // gets (useless) writable events.
+    bool flush(int fd) {
+        ConnectionState& connection = connections_[fd];
+        switch (connection.output.flush(fd)) {
+            case OutputBuffer::FlushResult::Done:
+                return !connection.writable_armed || set_writable_interest(fd, connection, false);
+            case OutputBuffer::FlushResult::WouldBlock:
+                if (options_.max_queued_output > 0 && connection.output.size() > options_.max_queued_output) {
+                    // the peer is not reading, holding on to its replies would grow our memory without bound
+                    break;
+                }
+                return connection.writable_armed || set_writable_interest(fd, connection, true);
+            case OutputBuffer::FlushResult::Error:
+                break;
+        }
+        close_connection(fd);
+        return false;
+    }
+
+    bool set_writable_interest(int fd, ConnectionState& connection, bool writable) {
+        struct epoll_event event{};
+        event.events = writable ? (EPOLLIN | EPOLLOUT | EPOLLET) : (EPOLLIN | EPOLLET);
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == -1) {
+            close_connection(fd);
+            return false;
+        }
+        connection.writable_armed = writable;
+        return true;
+    }
+
+    void close_connection(int fd) {
+        ConnectionState& connection = connections_[fd];
+        inputs_->release(std::move(connection.input));
+        connection.output.clear();
+        connection.flush_pending = false;
+        connection.writable_armed = false;
+        timers_->cancel(std::exchange(connection.idle_timer, {}));
+        connection.open = false;
+        if (std::exchange(connection.accepted, false)) {
+            metrics_.closed();
+        }
+        close(fd);
+    }
+
+    // heap allocated so that a moved reactor's output buffers keep pointing at a live pool
+    std::unique_ptr<BufferPool> pool_ = std::make_unique<BufferPool>(OutputBuffer::BLOCK_SIZE);
+    std::unique_ptr<MirroredBufferPool> inputs_ = std::make_unique<MirroredBufferPool>();
+    std::vector<ConnectionState> connections_;
     MessageHandler& handler_;
+    Options options_;
+    std::unique_ptr<TimerWheel> timers_;
+    TimerWheel::Clock::time_point loop_time_ {};
+    [[no_unique_address]] ReactorMetrics metrics_; // starts from zero in a moved reactor
     int epoll_fd_ { -1 };
-
-    static const int MAX_EVENTS { 64 };
-    static const int MAX_BUFFER_SIZE { 4096 }; // should be tuned accordingly (align with page size)
-    static const int MAX_CONNECTIONS { 1000 }; // should be tuned when we have more information
+    int wakeup_fd_ { -1 };
+    std::atomic<bool> stopped_ { false };
+    std::vector<int> pending_flushes_;
+    std::vector<struct epoll_event> events_;
+    int batch_size_ {};
+    static constexpr size_t MAX_MESSAGE_SIZE { 16 * 1024 * 1024 }; // connections sending larger messages are closed
 
     using TCPSocket = network::TCPSocket;
 };
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// <linux/io_uring.h> includes <linux/fs.h>, whose BLOCK_SIZE macro breaks OutputBuffer::BLOCK_SIZE
+#undef BLOCK_SIZE
+
+namespace network {
+
+/*
+* Minimal io_uring binding on the raw system calls (no liburing): the submission and completion rings are mapped
+* once, SQEs are filled in place and handed to the kernel in batches by submit(), and completions are read straight
+* from the shared completion ring. Not thread safe, a ring belongs to one reactor thread.
+*
+* With sq_poll a kernel thread polls the submission ring, so submitting costs no system call at all while the thread
+* is awake (it sleeps after sq_thread_idle_ms without work, submit() wakes it up).
+*/
+class IoUring {
+public:
+    struct Options {
+        unsigned entries = 1024;  // submission queue size, the completion queue is 4 times larger
+        bool sq_poll = false;
+        unsigned sq_thread_idle_ms = 1000;
+        int sq_thread_cpu = -1;   // CPU the polling thread is pinned to, -1 to let the scheduler decide
+    };
+
+    explicit IoUring(const Options& options) {
+        struct io_uring_params params{};
+        params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL;
+        params.cq_entries = options.entries * 4;
+        if (options.sq_poll) {
+            params.flags |= IORING_SETUP_SQPOLL;
+            params.sq_thread_idle = options.sq_thread_idle_ms;
+            if (options.sq_thread_cpu >= 0) {
+                params.flags |= IORING_SETUP_SQ_AFF;
+                params.sq_thread_cpu = static_cast<uint32_t>(options.sq_thread_cpu);
+            }
+        } else {
+            // completions are only processed when we enter the kernel anyway, no need to interrupt the thread
+            params.flags |= IORING_SETUP_COOP_TASKRUN;
+        }
+
+        fd_ = static_cast<int>(syscall(__NR_io_uring_setup, options.entries, &params));
+        if (fd_ == -1 && errno == EINVAL && !options.sq_poll) {
+            // kernels before 5.19 do not know COOP_TASKRUN
+            params = {};
+            params.flags = IORING_SETUP_CQSIZE;
+            params.cq_entries = options.entries * 4;
+            fd_ = static_cast<int>(syscall(__NR_io_uring_setup, options.entries, &params));
+        }
+        if (fd_ == -1) {
+            throw std::runtime_error("Unable to create io_uring instance.");
+        }
+        sq_poll_ = options.sq_poll;
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        single_mmap_ = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap_) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+
+        sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap_ ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqes_ = static_cast<struct io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+            release();
+            throw std::runtime_error("Unable to map io_uring rings.");
+        }
+
+        char* sq = static_cast<char*>(sq_ring_);
+        sq_head_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+        sq_flags_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.flags);
+        sq_mask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+        sq_entries_ = params.sq_entries;
+        // SQE i always sits in slot i, the indirection array is never changed after this
+        uint32_t* array = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+        for (uint32_t i = 0; i < sq_entries_; ++i) {
+            array[i] = i;
+        }
+
+        char* cq = static_cast<char*>(cq_ring_);
+        cq_head_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        sqe_tail_ = *sq_tail_;
+    }
+
+    ~IoUring() { release(); }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // A zeroed SQE, submitted by the next submit(). Submits the pending ones first if the queue is full.
+    // While completions overflow the completion queue the kernel may refuse new SQEs (EBUSY) until some are read, and
+    // the polling thread stops taking them, so then the completions are moved out of the ring into backlog_, where the
+    // next for_each_completion() finds them. Retrying the submit alone would spin forever.
+    struct io_uring_sqe& get_sqe() {
+        while (sqe_tail_ - std::atomic_ref(*sq_head_).load(std::memory_order_acquire) >= sq_entries_) {
+            if (std::atomic_ref(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_CQ_OVERFLOW) {
+                move_completions_to_backlog();
+            }
+            bool accepted = sq_poll_ ? enter(0, 0, IORING_ENTER_SQ_WAKEUP | IORING_ENTER_SQ_WAIT) : submit();
+            if (!accepted) {
+                move_completions_to_backlog();
+            }
+        }
+
+        struct io_uring_sqe& sqe = sqes_[sqe_tail_ & sq_mask_];
+        std::memset(&sqe, 0, sizeof(sqe));
+        ++sqe_tail_;
+        return sqe;
+    }
+
+    // Hands every SQE filled since the last call to the kernel and, with wait_for > 0, blocks until that many
+    // completions are available. One system call for all of it, none with sq_poll unless the polling thread sleeps
+    // or we have to wait. Returns false if the kernel took nothing this time (EBUSY: completions must be read first).
+    bool submit(unsigned wait_for = 0) {
+        std::atomic_ref(*sq_tail_).store(sqe_tail_, std::memory_order_release);
+
+        unsigned flags = wait_for > 0 ? IORING_ENTER_GETEVENTS : 0;
+        unsigned to_submit = 0;
+        if (sq_poll_) {
+            // the tail store must be visible before we look at the polling thread's flag, or it could go to sleep
+            // right after we checked it and never see the new entries
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (std::atomic_ref(*sq_flags_).load(std::memory_order_relaxed) & IORING_SQ_NEED_WAKEUP) {
+                flags |= IORING_ENTER_SQ_WAKEUP;
+            }
+        } else {
+            to_submit = sqe_tail_ - std::atomic_ref(*sq_head_).load(std::memory_order_relaxed);
+        }
+
+        if (to_submit > 0 || flags != 0) {
+            return enter(to_submit, wait_for, flags);
+        }
+        return true;
+    }
+
+    // number of completions waiting to be read
+    unsigned ready() const {
+        unsigned in_ring = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire) - *cq_head_;
+        return in_ring + static_cast<unsigned>(backlog_.size() - backlog_head_);
+    }
+
+    // Calls handle(cqe) for every available completion, returns how many there were.
+    // Each entry is copied out and released before handle() runs, so handle() may submit new requests. If that moves
+    // the rest of the ring to the backlog (see get_sqe()), those entries are handed out from there, still in order.
+    template <typename CompletionHandler>
+    unsigned for_each_completion(CompletionHandler&& handle) {
+        uint32_t tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+        unsigned count = 0;
+        for (;;) {
+            struct io_uring_cqe cqe;
+            if (backlog_head_ < backlog_.size()) {
+                cqe = backlog_[backlog_head_++];
+            } else {
+                backlog_.clear();
+                backlog_head_ = 0;
+                uint32_t head = *cq_head_;
+                // the head may have moved past our tail if handle() emptied the ring into the backlog
+                if (static_cast<int32_t>(tail - head) <= 0) {
+                    break;
+                }
+                cqe = cqes_[head & cq_mask_];
+                std::atomic_ref(*cq_head_).store(head + 1, std::memory_order_release);
+            }
+            handle(cqe);
+            ++count;
+        }
+        return count;
+    }
+
+    // Registers a ring of provided buffers (see BufferRing), recv requests with IOSQE_BUFFER_SELECT pick from it
+    void register_buffer_ring(struct io_uring_buf_ring* ring, unsigned entries, uint16_t group) {
+        struct io_uring_buf_reg registration{};
+        registration.ring_addr = reinterpret_cast<uint64_t>(ring);
+        registration.ring_entries = entries;
+        registration.bgid = group;
+        if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PBUF_RING, &registration, 1) == -1) {
+            throw std::runtime_error("Unable to register io_uring buffer ring.");
+        }
+    }
+
+    int get_fd() const { return fd_; }
+
+    // io_uring_enter calls made so far, to measure how well submissions are batched
+    uint64_t enter_calls() const { return enter_calls_; }
+
+private:
+    void* map(size_t size, uint64_t offset) {
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    // false if the call did nothing: EINTR, interrupted while waiting, EAGAIN/EBUSY, the completion queue must be
+    // drained first. Whatever was not submitted stays queued for the next call.
+    bool enter(unsigned to_submit, unsigned wait_for, unsigned flags) {
+        ++enter_calls_;
+        if (syscall(__NR_io_uring_enter, fd_, to_submit, wait_for, flags, nullptr, 0) == -1) {
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throw std::runtime_error("Unexpected error occurred during io_uring_enter.");
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // Frees the completion ring, so that the kernel can flush the completions it holds back into it
+    void move_completions_to_backlog() {
+        uint32_t head = *cq_head_;
+        uint32_t tail = std::atomic_ref(*cq_tail_).load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            backlog_.push_back(cqes_[head & cq_mask_]);
+        }
+        std::atomic_ref(*cq_head_).store(tail, std::memory_order_release);
+    }
+
+    void release() noexcept {
+        if (sqes_ != nullptr) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != nullptr) {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (fd_ != -1) {
+            close(fd_);
+        }
+    }
+
+    int fd_ { -1 };
+    bool sq_poll_ {};
+    bool single_mmap_ {};
+
+    void* sq_ring_ {};
+    size_t sq_ring_size_ {};
+    void* cq_ring_ {};
+    size_t cq_ring_size_ {};
+    struct io_uring_sqe* sqes_ {};
+    size_t sqes_size_ {};
+
+    uint32_t* sq_head_ {};
+    uint32_t* sq_tail_ {};
+    uint32_t* sq_flags_ {};
+    uint32_t sq_mask_ {};
+    uint32_t sq_entries_ {};
+    uint32_t sqe_tail_ {}; // SQEs handed out by get_sqe(), published to the kernel by submit()
+
+    uint32_t* cq_head_ {};
+    uint32_t* cq_tail_ {};
+    uint32_t cq_mask_ {};
+    struct io_uring_cqe* cqes_ {};
+    std::vector<struct io_uring_cqe> backlog_; // completions taken out of a full ring by get_sqe(), older than the ring's
+    size_t backlog_head_ {};
+
+    uint64_t enter_calls_ {};
+};
+
+/*
+* Provided buffers for multishot recv: count buffers of buffer_size bytes, and the ring through which they are handed
+* to the kernel. The kernel picks a buffer when data arrives (not when the recv is submitted), so one armed recv per
+* connection costs no memory until the connection actually receives something. The completion names the buffer it
+* used, and recycle() gives it back once its bytes were processed.
+*
+* Must outlive the IoUring it is registered with, the kernel may write into the buffers until the ring is closed.
+*/
+class BufferRing {
+public:
+    // count must be a power of two, at most 32768
+    BufferRing(unsigned count, size_t buffer_size, uint16_t group)
+        : count_ { count }, buffer_size_ { buffer_size }, group_ { group }
+    {
+        if (count == 0 || (count & (count - 1)) != 0 || count > 32768) {
+            throw std::invalid_argument("BufferRing needs a power of two buffer count, at most 32768.");
+        }
+
+        ring_size_ = count * sizeof(struct io_uring_buf);
+        void* ring = mmap(nullptr, ring_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        void* buffers = mmap(nullptr, count * buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring == MAP_FAILED || buffers == MAP_FAILED) {
+            if (ring != MAP_FAILED) {
+                munmap(ring, ring_size_);
+            }
+            if (buffers != MAP_FAILED) {
+                munmap(buffers, count * buffer_size);
+            }
+            throw std::runtime_error("Unable to allocate io_uring buffer ring.");
+        }
+        ring_ = static_cast<struct io_uring_buf_ring*>(ring);
+        buffers_ = static_cast<char*>(buffers);
+
+        for (unsigned id = 0; id < count; ++id) {
+            recycle(static_cast<uint16_t>(id));
+        }
+        publish();
+    }
+
+    ~BufferRing() {
+        munmap(ring_, ring_size_);
+        munmap(buffers_, count_ * buffer_size_);
+    }
+
+    BufferRing(const BufferRing&) = delete;
+    BufferRing& operator=(const BufferRing&) = delete;
+
+    char* buffer(uint16_t id) const { return buffers_ + id * buffer_size_; }
+
+    // queues buffer id to be handed back to the kernel by the next publish()
+    void recycle(uint16_t id) {
+        // not ring_->bufs: in C++ the uapi flexible array macro places it after an empty struct, at offset 8 instead
+        // of 0 (the ring is an array of io_uring_buf whose first entry's last field doubles as the tail)
+        struct io_uring_buf& entry = reinterpret_cast<struct io_uring_buf*>(ring_)[(tail_ + unpublished_) & (count_ - 1)];
+        entry.addr = reinterpret_cast<uint64_t>(buffer(id));
+        entry.len = static_cast<uint32_t>(buffer_size_);
+        entry.bid = id;
+        ++unpublished_;
+    }
+
+    void publish() {
+        if (unpublished_ > 0) {
+            tail_ += unpublished_;
+            unpublished_ = 0;
+            std::atomic_ref(ring_->tail).store(tail_, std::memory_order_release);
+        }
+    }
+
+    struct io_uring_buf_ring* ring() const { return ring_; }
+    unsigned count() const { return count_; }
+    size_t buffer_size() const { return buffer_size_; }
+    uint16_t group() const { return group_; }
+
+private:
+    unsigned count_;
+    size_t buffer_size_;
+    uint16_t group_;
+    size_t ring_size_;
+    struct io_uring_buf_ring* ring_ {};
+    char* buffers_ {};
+    uint16_t tail_ {};
+    uint16_t unpublished_ {};
+};
+
+// Whether this kernel supports what UringReactor needs (provided buffer rings, multishot accept and recv: Linux 6.0),
+// use EpollReactor otherwise. io_uring may also be disabled by the administrator (kernel.io_uring_disabled) or by a
+// seccomp filter, e.g. in containers.
+inline bool io_uring_supported() {
+    static const bool supported = [] {
+        try {
+            IoUring ring(IoUring::Options { .entries = 4 });
+            BufferRing buffers(1, 64, 0);
+            ring.register_buffer_ring(buffers.ring(), buffers.count(), buffers.group());
+
+            // multishot recv (6.0) cannot be probed for, the opcode exists since 5.6, so check the release instead
+            struct utsname name;
+            int major = 0, minor = 0;
+            return uname(&name) == 0 && std::sscanf(name.release, "%d.%d", &major, &minor) == 2 && major >= 6;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }();
+    return supported;
+}
+
+}
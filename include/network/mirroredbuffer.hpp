@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace network {
+
+/*
+* Byte ring buffer whose pages are mapped twice, back to back, so that both the buffered bytes and the free space are
+* always one contiguous range even when they wrap around the end of the ring ("magic ring buffer").
+* Data is received straight into space(), handed out from data(), and consume() just moves the read position: bytes
+* that are not consumed yet never move, however many times more data is appended behind them.
+*
+* The pages belong to an anonymous memfd that is closed once mapped, so a buffer holds no file descriptor.
+*/
+class MirroredBuffer {
+public:
+    // the capacity is rounded up to a multiple of the page size
+    explicit MirroredBuffer(size_t min_capacity)
+        : capacity_ { round_capacity(min_capacity) }
+    {
+        int fd = memfd_create("mirrored_buffer", MFD_CLOEXEC);
+        if (fd == -1) {
+            throw std::runtime_error("Unable to create memfd for mirrored buffer.");
+        }
+        if (ftruncate(fd, static_cast<off_t>(capacity_)) == -1) {
+            close(fd);
+            throw std::runtime_error("Unable to size memfd for mirrored buffer.");
+        }
+
+        // reserve twice the capacity first, so that both halves are guaranteed to be adjacent
+        void* reserved = mmap(nullptr, 2 * capacity_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (reserved == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Unable to reserve address space for mirrored buffer.");
+        }
+        base_ = static_cast<char*>(reserved);
+
+        for (char* half : { base_, base_ + capacity_ }) {
+            if (mmap(half, capacity_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+                munmap(base_, 2 * capacity_);
+                close(fd);
+                throw std::runtime_error("Unable to map mirrored buffer.");
+            }
+        }
+        close(fd);
+    }
+
+    ~MirroredBuffer() { munmap(base_, 2 * capacity_); }
+
+    static size_t round_capacity(size_t min_capacity) {
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (std::max(min_capacity, size_t { 1 }) + page_size - 1) / page_size * page_size;
+    }
+
+    MirroredBuffer(const MirroredBuffer&) = delete;
+    MirroredBuffer& operator=(const MirroredBuffer&) = delete;
+
+    // buffered bytes, contiguous
+    char* data() const { return base_ + head_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // free space right after the buffered bytes, contiguous, free_space() bytes long
+    char* space() const { return base_ + head_ + size_; }
+    size_t free_space() const { return capacity_ - size_; }
+
+    size_t capacity() const { return capacity_; }
+
+    // bytes written to space()
+    void commit(size_t bytes) { size_ += bytes; }
+
+    // drops the first bytes of data()
+    void consume(size_t bytes) {
+        size_ -= bytes;
+        head_ = size_ == 0 ? 0 : (head_ + bytes) % capacity_;
+    }
+
+    void clear() { head_ = size_ = 0; }
+
+private:
+    char* base_ {};
+    size_t capacity_ {};
+    size_t head_ {}; // always below capacity_, so space() + free_space() stays within the second mapping
+    size_t size_ {};
+};
+
+/*
+* Input buffers of one reactor, not thread safe.
+* Mapping a MirroredBuffer takes a handful of system calls, and its pages fault in again on first use, which costs far
+* more than the bytes it ever buffers. Released buffers are therefore kept for reuse, by size (the default capacity
+* times a power of two, as grow() doubles), as long as all spares together stay under max_spare_bytes.
+*/
+class MirroredBufferPool {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16384;
+
+    explicit MirroredBufferPool(size_t capacity = DEFAULT_CAPACITY, size_t max_spare_bytes = 16 * 1024 * 1024)
+        : capacity_ { MirroredBuffer::round_capacity(capacity) }
+        , max_spare_bytes_ { max_spare_bytes }
+    { }
+
+    MirroredBufferPool(const MirroredBufferPool&) = delete;
+    MirroredBufferPool& operator=(const MirroredBufferPool&) = delete;
+
+    std::unique_ptr<MirroredBuffer> acquire() { return take(capacity_); }
+
+    // A buffer twice as large holding the same bytes, for a message that does not fit. The old buffer is released,
+    // also when the larger one cannot be mapped (std::runtime_error, e.g. at the vm.max_map_count limit).
+    std::unique_ptr<MirroredBuffer> grow(std::unique_ptr<MirroredBuffer> buffer) {
+        std::unique_ptr<MirroredBuffer> larger;
+        try {
+            larger = take(buffer->capacity() * 2);
+        } catch (...) {
+            release(std::move(buffer));
+            throw;
+        }
+        std::memcpy(larger->space(), buffer->data(), buffer->size());
+        larger->commit(buffer->size());
+        release(std::move(buffer));
+        return larger;
+    }
+
+    void release(std::unique_ptr<MirroredBuffer> buffer) {
+        if (!buffer) {
+            return;
+        }
+        --in_use_;
+        if (spare_bytes_ + buffer->capacity() <= max_spare_bytes_) {
+            size_t size_class = std::countr_zero(buffer->capacity() / capacity_);
+            if (size_class >= spares_.size()) {
+                spares_.resize(size_class + 1);
+            }
+            spare_bytes_ += buffer->capacity();
+            buffer->clear();
+            spares_[size_class].push_back(std::move(buffer));
+        }
+    }
+
+    size_t capacity() const noexcept { return capacity_; }
+    size_t in_use() const noexcept { return in_use_; }
+    size_t spare_bytes() const noexcept { return spare_bytes_; }
+
+private:
+    std::unique_ptr<MirroredBuffer> take(size_t capacity) {
+        size_t size_class = std::countr_zero(capacity / capacity_);
+        std::unique_ptr<MirroredBuffer> buffer;
+        if (size_class < spares_.size() && !spares_[size_class].empty()) {
+            buffer = std::move(spares_[size_class].back());
+            spares_[size_class].pop_back();
+            spare_bytes_ -= buffer->capacity();
+        } else {
+            buffer = std::make_unique<MirroredBuffer>(capacity);
+        }
+        ++in_use_;
+        return buffer;
+    }
+
+    size_t capacity_;
+    size_t max_spare_bytes_;
+    size_t spare_bytes_ = 0;
+    size_t in_use_ = 0;
+    std::vector<std::vector<std::unique_ptr<MirroredBuffer>>> spares_; // by log2(capacity / capacity_)
+};
+
+}
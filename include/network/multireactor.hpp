@@ -0,0 +1,171 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "TCPSocket.hpp"
+#include "epollreactor.hpp"
+
+namespace network {
+
+// CPUs the process is allowed to run on, in increasing order
+inline std::vector<int> allowed_cpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &set) == -1) {
+        throw std::runtime_error("Unable to get the CPU affinity of the process.");
+    }
+
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+inline void pin_this_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set); rc != 0) {
+        throw std::runtime_error("Unable to pin thread to CPU " + std::to_string(cpu));
+    }
+}
+
+/*
+* Shared nothing multi-core server: N reactor threads, each pinned to its own CPU, with its own listening
+* socket bound to the same port with SO_REUSEPORT and its own handler instance.
+* The kernel hashes every incoming connection to one of the listeners, and the connection then lives on that
+* reactor's thread for its whole life, so handlers never need to synchronize and connection state never moves
+* between cores.
+*
+* The reactors are EpollReactors by default, MultiReactor<Handler, UringReactor<Handler>> runs io_uring reactors.
+*/
+template <HasOnDataMethod MessageHandler, typename Reactor = EpollReactor<MessageHandler>>
+class MultiReactor {
+private:
+    struct Shard {
+        template <typename HandlerFactory>
+        Shard(const std::string& port_number, HandlerFactory& make_handler, size_t index,
+              const typename Reactor::Options& options)
+            : handler { make_handler(index) }
+            , listener { port_number, true }
+            , reactor { handler, options }
+        {
+            listener.set_non_blocking();
+            listener.listen();
+            reactor.add_socket(listener.get_fd());
+        }
+
+        MessageHandler handler;
+        TCPSocket listener;
+        Reactor reactor;
+        std::thread thread;
+        std::exception_ptr error;
+    };
+
+public:
+    /*
+    * Creates reactor_count reactors listening on port_number ("0" picks a free port, see get_port()).
+    * make_handler(i) returns the handler of reactor i.
+    * Reactor i is pinned to cpus[i % cpus.size()], by default the CPUs the process is allowed to run on.
+    * Every reactor is created with the same options, e.g. to busy poll on dedicated cores.
+    */
+    template <typename HandlerFactory>
+    requires std::convertible_to<std::invoke_result_t<HandlerFactory&, size_t>, MessageHandler>
+    MultiReactor(const std::string& port_number, size_t reactor_count, HandlerFactory make_handler,
+                 std::vector<int> cpus = allowed_cpus(), const typename Reactor::Options& options = {})
+        : cpus_ { std::move(cpus) }
+    {
+        if (reactor_count == 0 || cpus_.empty()) {
+            throw std::invalid_argument("MultiReactor needs at least one reactor and one CPU.");
+        }
+
+        // every listener must bind the same port, so the kernel picked port (if any) is resolved by the first one
+        std::string port = port_number;
+        for (size_t i = 0; i < reactor_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>(port, make_handler, i, options));
+            port = shards_.front()->listener.get_port();
+        }
+    }
+
+    ~MultiReactor() {
+        stop();
+        for (auto& shard : shards_) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+    }
+
+    MultiReactor(const MultiReactor&) = delete;
+    MultiReactor& operator=(const MultiReactor&) = delete;
+
+    // Starts one pinned thread per reactor and returns immediately. The reactors can only be started once.
+    void start() {
+        if (started_) {
+            throw std::logic_error("MultiReactor was already started.");
+        }
+        started_ = true;
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            Shard& shard = *shards_[i];
+            int cpu = cpus_[i % cpus_.size()];
+            shard.thread = std::thread([&shard, cpu] {
+                try {
+                    pin_this_thread(cpu);
+                    shard.reactor.run(shard.listener);
+                } catch (...) {
+                    shard.error = std::current_exception();
+                }
+            });
+        }
+    }
+
+    // Asks every reactor to return from its event loop, can be called from any thread
+    void stop() {
+        for (auto& shard : shards_) {
+            shard->reactor.stop();
+        }
+    }
+
+    // Waits for every reactor thread to exit, rethrows the first exception that ended one of them
+    void join() {
+        for (auto& shard : shards_) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+        for (auto& shard : shards_) {
+            if (shard->error) {
+                std::rethrow_exception(std::exchange(shard->error, nullptr));
+            }
+        }
+    }
+
+    size_t size() const { return shards_.size(); }
+
+    // handler of reactor i, only safe to inspect once the reactors are stopped (or from the reactor's own thread)
+    MessageHandler& handler(size_t i) { return shards_[i]->handler; }
+
+    std::string get_port() { return shards_.front()->listener.get_port(); }
+
+private:
+    std::vector<int> cpus_;
+    bool started_ {};
+    // shards are heap allocated since the reactors keep references to their handler
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <utility>
+#include <vector>
+
+#include "bufferpool.hpp"
+
+namespace network {
+
+/*
+* Queue of bytes waiting to be sent on one connection.
+* Small writes are copied back to back into BLOCK_SIZE blocks, so many small responses go out in one syscall, and
+* a write larger than a block gets a block of its own instead of being split. flush() sends every queued block with
+* a single scatter-gather sendmsg (writev with MSG_NOSIGNAL, so a peer that went away does not raise SIGPIPE).
+*
+* Regular blocks come from the reactor's BufferPool (or the heap without one) and go back as soon as they are sent,
+* so an idle connection holds no output memory.
+*/
+class OutputBuffer {
+public:
+    static constexpr size_t BLOCK_SIZE = BufferPool::DEFAULT_BLOCK_SIZE;
+    static constexpr int MAX_IOVECS = 64;
+
+    enum class FlushResult {
+        Done,       // everything was sent
+        WouldBlock, // the socket buffer is full, the rest stays queued
+        Error       // the connection is broken
+    };
+
+    OutputBuffer() noexcept = default;
+
+    // the pool's block size must be BLOCK_SIZE
+    explicit OutputBuffer(BufferPool* pool) noexcept
+        : pool_ { pool }
+    { }
+
+    ~OutputBuffer() { clear(); }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    OutputBuffer(OutputBuffer&& other) noexcept
+        : blocks_ { std::move(other.blocks_) }
+        , pool_ { other.pool_ }
+        , size_ { std::exchange(other.size_, 0) }
+    {
+        other.blocks_.clear();
+    }
+
+    OutputBuffer& operator=(OutputBuffer&& other) noexcept {
+        if (this != &other) {
+            clear();
+            blocks_ = std::move(other.blocks_);
+            other.blocks_.clear();
+            pool_ = other.pool_;
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    void append(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        size_ += size;
+
+        if (!blocks_.empty()) {
+            Block& tail = blocks_.back();
+            size_t copied = std::min(size, tail.capacity - tail.end);
+            std::memcpy(tail.data + tail.end, bytes, copied);
+            tail.end += copied;
+            bytes += copied;
+            size -= copied;
+        }
+
+        if (size > 0) {
+            Block& block = new_block(size);
+            std::memcpy(block.data, bytes, size);
+            block.end = size;
+        }
+    }
+
+    FlushResult flush(int fd) {
+        while (!blocks_.empty()) {
+            struct iovec iov[MAX_IOVECS];
+            struct msghdr message{};
+            message.msg_iov = iov;
+            message.msg_iovlen = gather(iov, MAX_IOVECS);
+            ssize_t bytes_sent = sendmsg(fd, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (bytes_sent == -1) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return FlushResult::WouldBlock;
+                }
+                if (errno == EINTR) {
+                    continue;
+                }
+                return FlushResult::Error;
+            }
+
+            consume(static_cast<size_t>(bytes_sent));
+        }
+        return FlushResult::Done;
+    }
+
+    // Points iov at the first (at most max_iovecs) queued blocks, for a caller that sends them itself (e.g. through
+    // io_uring) and reports what was sent with consume(). Appending does not move queued bytes, so the iovecs stay
+    // valid until consume() or clear().
+    int gather(struct iovec* iov, int max_iovecs) const {
+        int count = 0;
+        for (auto it = blocks_.begin(); it != blocks_.end() && count < max_iovecs; ++it, ++count) {
+            iov[count].iov_base = it->data + it->begin;
+            iov[count].iov_len = it->end - it->begin;
+        }
+        return count;
+    }
+
+    // drops the first bytes of the queue, which were sent
+    void consume(size_t bytes) {
+        size_ -= bytes;
+        size_t sent_blocks = 0;
+        while (bytes > 0) {
+            Block& front = blocks_[sent_blocks];
+            size_t taken = std::min(bytes, front.end - front.begin);
+            front.begin += taken;
+            bytes -= taken;
+            if (front.begin == front.end) {
+                release(front);
+                ++sent_blocks;
+            }
+        }
+
+        blocks_.erase(blocks_.begin(), blocks_.begin() + sent_blocks);
+    }
+
+    // drops everything, including the block list's own memory, e.g. when the connection is closed
+    void clear() {
+        for (Block& block : blocks_) {
+            release(block);
+        }
+        blocks_ = {};
+        size_ = 0;
+    }
+
+    bool empty() const { return size_ == 0; }
+
+    size_t size() const { return size_; }
+
+private:
+    struct Block {
+        char* data;
+        size_t capacity;
+        size_t begin;
+        size_t end;
+    };
+
+    Block& new_block(size_t min_size) {
+        if (min_size <= BLOCK_SIZE) {
+            char* data = pool_ ? pool_->allocate() : new char[BLOCK_SIZE];
+            blocks_.push_back(Block { data, BLOCK_SIZE, 0, 0 });
+        } else {
+            blocks_.push_back(Block { new char[min_size], min_size, 0, 0 });
+        }
+        return blocks_.back();
+    }
+
+    void release(Block& block) noexcept {
+        if (block.capacity == BLOCK_SIZE && pool_) {
+            pool_->deallocate(block.data);
+        } else {
+            delete[] block.data;
+        }
+    }
+
+    std::vector<Block> blocks_;
+    BufferPool* pool_ = nullptr;
+    size_t size_ = 0;
+};
+
+}
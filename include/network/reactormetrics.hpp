@@ -0,0 +1,230 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+* Reactor instrumentation, enabled by compiling with -DCUSTOMSTL_REACTOR_METRICS (every translation unit of a program
+* must agree, otherwise EpollReactor violates the ODR).
+*
+* The reactor thread records, per loop iteration:
+*   - events returned by epoll_wait,
+*   - iteration time: from epoll_wait returning until the replies of the batch were flushed,
+*   - handler time of every on_data call,
+*   - bytes of every recv that returned data, and how many recvs ended in EAGAIN,
+*   - accepted and closed connections.
+* Durations are raw TSC reads converted to nanoseconds, and every counter has a single writer, so recording is plain
+* load + store (no locked RMW) and snapshot() can be called from any thread without locks. A snapshot is not atomic as
+* a whole: each counter is exact, but counters may be a few events apart from each other.
+*
+* When metrics are disabled ReactorMetrics is an empty class with inline no-op members, stored [[no_unique_address]]
+* in the reactor, so it has the same size and code as without it, and snapshot() returns zeros.
+*/
+
+namespace network {
+
+// Log2 histogram: bucket i counts the values whose bit width is i, that is [2^(i-1), 2^i), and bucket 0 counts zeros
+struct HistogramSnapshot {
+    static constexpr int BUCKETS = 65;
+
+    std::array<uint64_t, BUCKETS> buckets {};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    double mean() const { return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count); }
+
+    // upper bound of the bucket holding the given quantile (0 to 1), at most the largest value seen
+    uint64_t percentile(double quantile) const {
+        uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(count));
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen > rank) {
+                uint64_t upper = i == 0 ? 0 : (i == 64 ? UINT64_MAX : (uint64_t { 1 } << i) - 1);
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+};
+
+struct ReactorStats {
+    std::chrono::steady_clock::time_point time {};
+    HistogramSnapshot events_per_wait;
+    HistogramSnapshot iteration_ns;
+    HistogramSnapshot handler_ns;
+    HistogramSnapshot recv_bytes;
+    uint64_t recv_calls = 0; // that returned data or EAGAIN
+    uint64_t recv_would_block = 0;
+    uint64_t accepted = 0;
+    uint64_t closed = 0;
+
+    // share of recv calls that found no data: each drain of an edge triggered socket ends with one
+    double would_block_ratio() const {
+        return recv_calls == 0 ? 0.0 : static_cast<double>(recv_would_block) / static_cast<double>(recv_calls);
+    }
+
+    // connections accepted by the reactor and not closed yet
+    uint64_t open_connections() const { return accepted - closed; }
+
+    // accepted connections per second since an earlier snapshot
+    double accept_rate(const ReactorStats& earlier) const {
+        double seconds = std::chrono::duration<double>(time - earlier.time).count();
+        return seconds <= 0.0 ? 0.0 : static_cast<double>(accepted - earlier.accepted) / seconds;
+    }
+};
+
+}
+
+#ifdef CUSTOMSTL_REACTOR_METRICS
+
+#include <atomic>
+#include <immintrin.h>
+#include <thread>
+
+namespace network {
+
+namespace reactor_metrics {
+    // single writer, see above
+    inline void add(std::atomic<uint64_t>& counter, uint64_t value) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    class Histogram {
+    public:
+        void record(uint64_t value) noexcept {
+            add(buckets_[std::bit_width(value)], 1);
+            add(count_, 1);
+            add(sum_, value);
+            if (value > max_.load(std::memory_order_relaxed)) {
+                max_.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        HistogramSnapshot snapshot() const noexcept {
+            HistogramSnapshot result;
+            for (int i = 0; i < HistogramSnapshot::BUCKETS; ++i) {
+                result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+            }
+            result.count = count_.load(std::memory_order_relaxed);
+            result.sum = sum_.load(std::memory_order_relaxed);
+            result.max = max_.load(std::memory_order_relaxed);
+            return result;
+        }
+
+    private:
+        std::atomic<uint64_t> buckets_[HistogramSnapshot::BUCKETS] {};
+        std::atomic<uint64_t> count_ { 0 };
+        std::atomic<uint64_t> sum_ { 0 };
+        std::atomic<uint64_t> max_ { 0 };
+    };
+
+    // TSC frequency, measured once against steady_clock over ~10ms
+    inline double ns_per_cycle() {
+        static const double value = [] {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t start_cycles = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            uint64_t cycles = __rdtsc() - start_cycles;
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            return static_cast<double>(ns) / static_cast<double>(cycles);
+        }();
+        return value;
+    }
+} // namespace reactor_metrics
+
+class ReactorMetrics {
+public:
+    static constexpr bool enabled = true;
+
+    ReactorMetrics()
+        : ns_per_cycle_ { reactor_metrics::ns_per_cycle() }
+    { }
+
+    ReactorMetrics(const ReactorMetrics&) = delete;
+    ReactorMetrics& operator=(const ReactorMetrics&) = delete;
+
+    uint64_t timestamp() const noexcept { return __rdtsc(); }
+
+    void waited(int events) noexcept { events_per_wait_.record(static_cast<uint64_t>(events)); }
+    void iteration_done(uint64_t start) noexcept { iteration_ns_.record(elapsed_ns(start)); }
+    void handled(uint64_t start) noexcept { handler_ns_.record(elapsed_ns(start)); }
+
+    void received(size_t bytes) noexcept {
+        reactor_metrics::add(recv_calls_, 1);
+        recv_bytes_.record(bytes);
+    }
+
+    void would_block() noexcept {
+        reactor_metrics::add(recv_calls_, 1);
+        reactor_metrics::add(recv_would_block_, 1);
+    }
+
+    void accepted() noexcept { reactor_metrics::add(accepted_, 1); }
+    void closed() noexcept { reactor_metrics::add(closed_, 1); }
+
+    // can be called from any thread
+    ReactorStats snapshot() const noexcept {
+        ReactorStats stats;
+        stats.time = std::chrono::steady_clock::now();
+        stats.events_per_wait = events_per_wait_.snapshot();
+        stats.iteration_ns = iteration_ns_.snapshot();
+        stats.handler_ns = handler_ns_.snapshot();
+        stats.recv_bytes = recv_bytes_.snapshot();
+        stats.recv_calls = recv_calls_.load(std::memory_order_relaxed);
+        stats.recv_would_block = recv_would_block_.load(std::memory_order_relaxed);
+        // closed first, so that open_connections() never goes negative
+        stats.closed = closed_.load(std::memory_order_relaxed);
+        stats.accepted = accepted_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    uint64_t elapsed_ns(uint64_t start) const noexcept {
+        return static_cast<uint64_t>(static_cast<double>(__rdtsc() - start) * ns_per_cycle_);
+    }
+
+    double ns_per_cycle_;
+    reactor_metrics::Histogram events_per_wait_;
+    reactor_metrics::Histogram iteration_ns_;
+    reactor_metrics::Histogram handler_ns_;
+    reactor_metrics::Histogram recv_bytes_;
+    std::atomic<uint64_t> recv_calls_ { 0 };
+    std::atomic<uint64_t> recv_would_block_ { 0 };
+    std::atomic<uint64_t> accepted_ { 0 };
+    std::atomic<uint64_t> closed_ { 0 };
+};
+
+}
+
+#else
+
+namespace network {
+
+class ReactorMetrics {
+public:
+    static constexpr bool enabled = false;
+
+    constexpr uint64_t timestamp() const noexcept { return 0; }
+    constexpr void waited(int) noexcept { }
+    constexpr void iteration_done(uint64_t) noexcept { }
+    constexpr void handled(uint64_t) noexcept { }
+    constexpr void received(size_t) noexcept { }
+    constexpr void would_block() noexcept { }
+    constexpr void accepted() noexcept { }
+    constexpr void closed() noexcept { }
+
+    ReactorStats snapshot() const noexcept {
+        ReactorStats stats;
+        stats.time = std::chrono::steady_clock::now();
+        return stats;
+    }
+};
+
+}
+
+#endif
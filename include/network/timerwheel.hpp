@@ -0,0 +1,374 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "customSTL/inplace_function.hpp"
+#include "customSTL/object_pool.hpp"
+
+namespace network {
+
+/*
+* Hierarchical timing wheel (Varghese & Lauck), for the timers of one reactor, not thread safe.
+* Time advances in ticks of `resolution`. Level 0 has one slot per tick for the next 64 ticks, and each level above
+* covers 64 times the span of the one below, so 4 levels reach 2^24 ticks (4.6 hours at 1ms); later timers wait in
+* the last slot and are placed again when it is reached. Scheduling and cancelling only link or unlink a node, and a
+* timer of level n moves down at most n times, when the slots below wrap around.
+*
+* Time only moves in advance(now), which collects every timer that came due into one batch and then runs the batch.
+* Delays are relative to the time of the last advance(): for a reactor, the start of the current loop iteration.
+* A timer never fires early, and at most one tick after its deadline plus however long the loop takes to call
+* advance(). Callbacks may schedule, cancel and reschedule any timer, including their own.
+*
+* Nodes come from ObjectPool slabs, each twice as large as the previous one, and cancelled or expired nodes are
+* reused for the next timers, so a steady number of timers does not allocate.
+*/
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = CustomSTL::inplace_move_only_function<void(), 48>;
+
+    static constexpr int BITS_PER_LEVEL = 6;
+    static constexpr int SLOTS_PER_LEVEL = 1 << BITS_PER_LEVEL;
+    static constexpr int LEVELS = 4;
+
+private:
+    struct Link {
+        Link* prev;
+        Link* next;
+    };
+
+    // slot is the index in slots_ of the list holding the node, or one of the states below
+    static constexpr uint16_t EXPIRED = LEVELS * SLOTS_PER_LEVEL; // in the batch being run
+    static constexpr uint16_t RUNNING = EXPIRED + 1;              // its callback is running
+    static constexpr uint16_t FREE = EXPIRED + 2;
+
+    struct Node : Link {
+        uint64_t expires = 0; // tick
+        uint64_t generation = 1;
+        uint16_t slot = FREE;
+        Callback callback;
+    };
+
+public:
+    // Handle to a scheduled timer. It goes stale once the timer ran or was cancelled, even if its node is reused.
+    class TimerId {
+    public:
+        TimerId() noexcept = default;
+
+        explicit operator bool() const noexcept { return node_ != nullptr; }
+
+    private:
+        friend class TimerWheel;
+
+        TimerId(Node* node, uint64_t generation) noexcept
+            : node_ { node }
+            , generation_ { generation }
+        { }
+
+        Node* node_ = nullptr;
+        uint64_t generation_ = 0;
+    };
+
+    explicit TimerWheel(Clock::duration resolution = std::chrono::milliseconds(1), Clock::time_point now = Clock::now())
+        : resolution_ { std::max(resolution, Clock::duration { 1 }) }
+        , start_ { now }
+        , now_ { now }
+    {
+        for (Link& slot : slots_) {
+            slot.prev = slot.next = &slot;
+        }
+        for (Link* list : { &expired_, &free_ }) {
+            list->prev = list->next = list;
+        }
+    }
+
+    ~TimerWheel() {
+        for (Link& slot : slots_) {
+            release_all(slot);
+        }
+        release_all(expired_);
+        release_all(free_);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    TimerId schedule(Clock::duration delay, Callback callback) {
+        Node* node = acquire_node();
+        node->callback = std::move(callback);
+        node->expires = deadline(delay);
+        link(node);
+        ++size_;
+        return TimerId(node, node->generation);
+    }
+
+    // Returns false if the timer already ran or was cancelled
+    bool cancel(TimerId id) {
+        if (!pending(id)) {
+            return false;
+        }
+        unlink(id.node_);
+        free_node(id.node_);
+        --size_;
+        return true;
+    }
+
+    // Moves a pending timer (or the one whose callback is running) to now + delay. Returns false if the timer is gone.
+    bool reschedule(TimerId id, Clock::duration delay) {
+        Node* node = id.node_;
+        if (node == nullptr || node->generation != id.generation_ || node->slot == FREE) {
+            return false;
+        }
+        if (node->slot == RUNNING) {
+            ++size_;
+        } else {
+            unlink(node);
+        }
+        node->expires = deadline(delay);
+        link(node);
+        return true;
+    }
+
+    // Moves time to now and runs every timer that came due, returns how many ran
+    size_t advance(Clock::time_point now) {
+        now_ = std::max(now_, now);
+        uint64_t target = tick(now_);
+        while (current_ <= target) {
+            if ((current_ & MASK) == 0) {
+                cascade();
+            }
+            if (empty_wheel()) {
+                current_ = target + 1;
+                break;
+            }
+            splice(slots_[current_ & MASK], expired_);
+            ++current_;
+
+            // skip the empty ticks of level 0, up to the next cascade
+            if ((current_ & MASK) != 0) {
+                uint64_t later_slots = occupied_[0] >> (current_ & MASK);
+                uint64_t next = later_slots ? current_ + std::countr_zero(later_slots) : (current_ | MASK) + 1;
+                current_ = std::min(next, target + 1);
+            }
+        }
+        return run_expired();
+    }
+
+    // Time from the last advance() until the next timer may be due, Clock::duration::max() without timers.
+    // The wheel does not know the exact deadline of timers above level 0, so this may be earlier: the caller then
+    // advances without running anything, and asks again.
+    Clock::duration next_timeout() const {
+        if (empty_wheel()) {
+            return size_ == 0 ? Clock::duration::max() : Clock::duration::zero();
+        }
+
+        uint64_t next = (current_ | MASK) + 1;
+        uint64_t level0 = std::rotr(occupied_[0], static_cast<int>(current_ & MASK));
+        if (level0 != 0) {
+            next = std::min(next, current_ + std::countr_zero(level0));
+        }
+        Clock::time_point due = start_ + static_cast<Clock::rep>(next) * resolution_;
+        return std::max(due - now_, Clock::duration::zero());
+    }
+
+    Clock::time_point now() const noexcept { return now_; }
+    Clock::duration resolution() const noexcept { return resolution_; }
+
+    // scheduled timers that did not run yet
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    // nodes allocated from the pools, pending or waiting for reuse
+    size_t node_count() const noexcept { return node_count_; }
+
+private:
+    static constexpr uint64_t MASK = SLOTS_PER_LEVEL - 1;
+    static constexpr uint64_t RANGE = uint64_t { 1 } << (BITS_PER_LEVEL * LEVELS);
+
+    bool pending(TimerId id) const {
+        Node* node = id.node_;
+        return node != nullptr && node->generation == id.generation_ && node->slot != FREE && node->slot != RUNNING;
+    }
+
+    uint64_t tick(Clock::time_point time) const {
+        return static_cast<uint64_t>((time - start_) / resolution_);
+    }
+
+    // first tick at or after now + delay, so that a timer never fires before its deadline
+    uint64_t deadline(Clock::duration delay) const {
+        uint64_t ticks = ticks_up(now_ - start_) + ticks_up(std::max(delay, Clock::duration::zero()));
+        return std::max(ticks, current_);
+    }
+
+    uint64_t ticks_up(Clock::duration duration) const {
+        return static_cast<uint64_t>(duration / resolution_ + (duration % resolution_ != Clock::duration::zero()));
+    }
+
+    bool empty_wheel() const {
+        return std::all_of(std::begin(occupied_), std::end(occupied_), [](uint64_t bits) { return bits == 0; });
+    }
+
+    void link(Node* node) {
+        uint64_t delta = std::min(node->expires - current_, RANGE - 1);
+        uint64_t expires = current_ + delta; // timers beyond the top level wait in its last slot
+        int level = 0;
+        while (delta >= (uint64_t { 1 } << (BITS_PER_LEVEL * (level + 1)))) {
+            ++level;
+        }
+        int index = static_cast<int>((expires >> (BITS_PER_LEVEL * level)) & MASK);
+
+        Link& slot = slots_[level * SLOTS_PER_LEVEL + index];
+        insert_before(slot, node);
+        node->slot = static_cast<uint16_t>(level * SLOTS_PER_LEVEL + index);
+        occupied_[level] |= uint64_t { 1 } << index;
+    }
+
+    void unlink(Node* node) {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        if (node->slot < EXPIRED) {
+            Link& slot = slots_[node->slot];
+            if (slot.next == &slot) {
+                occupied_[node->slot / SLOTS_PER_LEVEL] &= ~(uint64_t { 1 } << (node->slot % SLOTS_PER_LEVEL));
+            }
+        }
+    }
+
+    static void insert_before(Link& position, Link* link) {
+        link->prev = position.prev;
+        link->next = &position;
+        position.prev->next = link;
+        position.prev = link;
+    }
+
+    // moves a level 0 slot to the end of the expired batch
+    void splice(Link& slot, Link& batch) {
+        if (slot.next == &slot) {
+            return;
+        }
+        for (Link* link = slot.next; link != &slot; link = link->next) {
+            static_cast<Node*>(link)->slot = EXPIRED;
+        }
+        slot.next->prev = batch.prev;
+        batch.prev->next = slot.next;
+        slot.prev->next = &batch;
+        batch.prev = slot.prev;
+        slot.prev = slot.next = &slot;
+        occupied_[0] &= ~(uint64_t { 1 } << (current_ & MASK));
+    }
+
+    // Level 0 wrapped around: the current slot of level 1 moves down, and so on up while the levels wrap as well
+    void cascade() {
+        for (int level = 1; level < LEVELS; ++level) {
+            int index = static_cast<int>((current_ >> (BITS_PER_LEVEL * level)) & MASK);
+            Link& slot = slots_[level * SLOTS_PER_LEVEL + index];
+            Link moving = slot;
+            if (slot.next != &slot) {
+                moving.next->prev = moving.prev->next = &moving;
+                slot.prev = slot.next = &slot;
+                occupied_[level] &= ~(uint64_t { 1 } << index);
+                while (moving.next != &moving) {
+                    Node* node = static_cast<Node*>(moving.next);
+                    moving.next = node->next;
+                    node->next->prev = &moving;
+                    link(node);
+                }
+            }
+            if (index != 0) {
+                break;
+            }
+        }
+    }
+
+    size_t run_expired() {
+        size_t ran = 0;
+        while (expired_.next != &expired_) {
+            Node* node = static_cast<Node*>(expired_.next);
+            unlink(node);
+            node->slot = RUNNING;
+            --size_;
+            running_ = node;
+            try {
+                node->callback();
+            } catch (...) {
+                finish_running(node);
+                throw;
+            }
+            finish_running(node);
+            ++ran;
+        }
+        return ran;
+    }
+
+    // the node is reused unless its callback rescheduled it
+    void finish_running(Node* node) {
+        running_ = nullptr;
+        if (node->slot == RUNNING) {
+            free_node(node);
+        }
+    }
+
+    Node* acquire_node() {
+        if (free_.next != &free_) {
+            Node* node = static_cast<Node*>(free_.next);
+            free_.next = node->next;
+            node->next->prev = &free_;
+            return node;
+        }
+
+        Node* node = pools_.empty() ? nullptr : pools_.back()->acquire();
+        if (node == nullptr) {
+            size_t capacity = pools_.empty() ? 64 : pools_.back()->capacity() * 2;
+            pools_.push_back(std::make_unique<CustomSTL::ObjectPool<Node>>(capacity));
+            node = pools_.back()->acquire();
+        }
+        ++node_count_;
+        return node;
+    }
+
+    // A cancelled timer whose callback is running keeps it until it returns
+    void free_node(Node* node) {
+        ++node->generation;
+        if (node == running_) {
+            node->slot = RUNNING;
+            return;
+        }
+        node->callback = nullptr;
+        node->slot = FREE;
+        insert_before(free_, node);
+    }
+
+    void release_all(Link& list) {
+        while (list.next != &list) {
+            Node* node = static_cast<Node*>(list.next);
+            list.next = node->next;
+            for (auto& pool : pools_) {
+                if (pool->owns(node)) {
+                    pool->release(node);
+                    break;
+                }
+            }
+        }
+    }
+
+    Clock::duration resolution_;
+    Clock::time_point start_;
+    Clock::time_point now_;
+    uint64_t current_ = 0; // first tick that was not processed yet
+    size_t size_ = 0;
+    size_t node_count_ = 0;
+    Link slots_[LEVELS * SLOTS_PER_LEVEL];
+    uint64_t occupied_[LEVELS] = {}; // non empty slots of each level
+    Link expired_;
+    Link free_;
+    Node* running_ = nullptr;
+    std::vector<std::unique_ptr<CustomSTL::ObjectPool<Node>>> pools_;
+};
+
+}
@@ -0,0 +1,454 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "TCPSocket.hpp"
+#include "bufferpool.hpp"
+#include "epollreactor.hpp"
+#include "iouring.hpp"
+#include "mirroredbuffer.hpp"
+#include "outputbuffer.hpp"
+
+namespace network {
+
+/*
+* io_uring based reactor, a drop-in replacement for EpollReactor (same handlers, same add_socket/run/send/stop) on
+* Linux 6.0 and later, see io_uring_supported().
+*
+* Instead of waiting for readiness and then reading, every request stays armed in the kernel:
+*   - one multishot accept on the listening socket produces a completion per new connection,
+*   - one multishot recv per connection produces a completion per received chunk, in a buffer the kernel picks from
+*     a ring of provided buffers when the data arrives, so nothing is allocated per connection up front,
+*   - replies are sent with one sendmsg request per connection with queued output.
+* Every new request of a loop iteration (re-armed requests, sends, wakeup) is submitted together with the wait for
+* the next completions, in a single io_uring_enter (none at all with sq_poll while its kernel thread is awake).
+*/
+template <HasOnDataMethod MessageHandler>
+class UringReactor {
+private:
+    // Received bytes are handed to the handler straight from the provided buffer. Only what it does not consume is
+    // copied into the connection's own input ring (see EpollReactor), which is given back as soon as it is empty.
+    struct ConnectionState {
+        std::unique_ptr<MirroredBuffer> input;
+        OutputBuffer output;
+        std::unique_ptr<struct msghdr> message; // argument of the send in flight, allocated on the first send
+        std::unique_ptr<struct iovec[]> iovecs;
+        bool open{};
+        bool closing{};         // shut down, closed once the kernel returned every request on it
+        bool recv_armed{};
+        bool send_in_flight{};
+        bool flush_pending{};
+    };
+
+    enum class Operation : uint64_t { Accept, AcceptRetry, Recv, Send, Wakeup };
+
+public:
+    struct Options {
+        IoUring::Options ring {};
+        unsigned buffer_count = 1024;   // provided receive buffers, shared by every connection of the reactor
+        size_t buffer_size = BufferPool::DEFAULT_BLOCK_SIZE;
+    };
+
+    UringReactor(MessageHandler& handler, const Options& options = {})
+        : buffers_ { options.buffer_count, options.buffer_size, BUFFER_GROUP }
+        , ring_ { options.ring }
+        , handler_ { handler }
+    {
+        ring_.register_buffer_ring(buffers_.ring(), buffers_.count(), buffers_.group());
+
+        wakeup_fd_ = eventfd(0, EFD_CLOEXEC);
+        if (wakeup_fd_ == -1) {
+            throw std::runtime_error("Unable to create wakeup eventfd.");
+        }
+    }
+
+    ~UringReactor() {
+        if (wakeup_fd_ != -1) {
+            close(wakeup_fd_);
+        }
+    }
+
+    UringReactor(const UringReactor&) = delete;
+    UringReactor& operator=(const UringReactor&) = delete;
+
+    // Registers a connected socket, its recv is armed by the event loop. The listening socket passed to run() may be
+    // added too, as with EpollReactor, it is recognized and gets an accept instead.
+    void add_socket(int fd) {
+        if (fd == -1) [[unlikely]] {
+            throw std::runtime_error("File descriptor passed in is invalid.");
+        }
+
+        if (static_cast<size_t>(fd) >= connections_.size()) {
+            connections_.resize(std::max(static_cast<size_t>(fd) + 1, connections_.size() * 2));
+        }
+        ConnectionState& connection = connections_[fd];
+        inputs_->release(std::move(connection.input));
+        connection.output = OutputBuffer(pool_.get());
+        connection.open = true;
+        connection.closing = false;
+        connection.flush_pending = false;
+        unarmed_.push_back(fd);
+    }
+
+    // Runs the event loop on the calling thread until stop() is called
+    void run(TCPSocket& server_socket) {
+        listener_fd_ = server_socket.get_fd();
+
+        while (!stopped_.load(std::memory_order_acquire)) {
+            if (!accept_armed_) {
+                arm_accept();
+            }
+            if (!wakeup_armed_) {
+                arm_wakeup();
+            }
+            arm_new_sockets();
+            // responses queued while handling the last batch go out with the same system call
+            flush_pending();
+            buffers_.publish();
+
+            ring_.submit(ring_.ready() == 0 ? 1 : 0);
+            ring_.for_each_completion([this](const struct io_uring_cqe& cqe) { complete(cqe); });
+        }
+    }
+
+    // Queues data on the connection's output buffer, it is sent once the current batch of completions is handled.
+    // Must be called from the reactor's thread (e.g. from a handler).
+    void send(int fd, const void* data, size_t size) {
+        if (fd < 0 || static_cast<size_t>(fd) >= connections_.size() || !connections_[fd].open ||
+            connections_[fd].closing) [[unlikely]] {
+            return;
+        }
+        ConnectionState& connection = connections_[fd];
+        connection.output.append(data, size);
+        mark_pending(fd, connection);
+    }
+
+    // Makes run() return after the completions it is currently processing, can be called from any thread
+    void stop() {
+        stopped_.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t rc = write(wakeup_fd_, &one, sizeof(one));
+    }
+
+    // buffers currently taken by connections, for monitoring memory use
+    const BufferPool& buffer_pool() const { return *pool_; }
+    const MirroredBufferPool& input_buffers() const { return *inputs_; }
+
+    // io_uring_enter calls made by the event loop so far
+    uint64_t enter_calls() const { return ring_.enter_calls(); }
+
+private:
+    static uint64_t user_data(Operation operation, int fd) {
+        return (static_cast<uint64_t>(operation) << 32) | static_cast<uint32_t>(fd);
+    }
+
+    void arm_accept() {
+        struct io_uring_sqe& sqe = ring_.get_sqe();
+        sqe.opcode = IORING_OP_ACCEPT;
+        sqe.fd = listener_fd_;
+        sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe.accept_flags = SOCK_CLOEXEC;
+        sqe.user_data = user_data(Operation::Accept, listener_fd_);
+        accept_armed_ = true;
+    }
+
+    void arm_wakeup() {
+        struct io_uring_sqe& sqe = ring_.get_sqe();
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = wakeup_fd_;
+        sqe.addr = reinterpret_cast<uint64_t>(&wakeup_value_);
+        sqe.len = sizeof(wakeup_value_);
+        sqe.off = static_cast<uint64_t>(-1);
+        sqe.user_data = user_data(Operation::Wakeup, wakeup_fd_);
+        wakeup_armed_ = true;
+    }
+
+    void arm_recv(int fd, ConnectionState& connection) {
+        struct io_uring_sqe& sqe = ring_.get_sqe();
+        sqe.opcode = IORING_OP_RECV;
+        sqe.fd = fd;
+        sqe.ioprio = IORING_RECV_MULTISHOT;
+        sqe.flags = IOSQE_BUFFER_SELECT;
+        sqe.buf_group = buffers_.group();
+        sqe.user_data = user_data(Operation::Recv, fd);
+        connection.recv_armed = true;
+    }
+
+    void arm_new_sockets() {
+        for (int fd : unarmed_) {
+            ConnectionState& connection = connections_[fd];
+            if (fd != listener_fd_ && connection.open && !connection.closing && !connection.recv_armed) {
+                arm_recv(fd, connection);
+            }
+        }
+        unarmed_.clear();
+    }
+
+    void complete(const struct io_uring_cqe& cqe) {
+        int fd = static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+        bool more = cqe.flags & IORING_CQE_F_MORE;
+
+        switch (static_cast<Operation>(cqe.user_data >> 32)) {
+            case Operation::Wakeup:
+                // stop() was called, checked by the loop condition
+                wakeup_armed_ = false;
+                return;
+            case Operation::Accept:
+                accepted(cqe.res, more);
+                return;
+            case Operation::AcceptRetry:
+                accept_armed_ = false;
+                return;
+            case Operation::Recv:
+                received(fd, cqe, more);
+                break;
+            case Operation::Send:
+                sent(fd, cqe.res);
+                break;
+        }
+
+        ConnectionState& connection = connections_[fd];
+        if (connection.closing && !connection.recv_armed && !connection.send_in_flight) {
+            finish_close(fd, connection);
+        }
+    }
+
+    void accepted(int result, bool more) {
+        // the kernel ends a multishot request on errors or when it runs out of completion queue space
+        accept_armed_ = more;
+        if (result >= 0) {
+            add_socket(result);
+            accept_backoff_ms_ = 0;
+        } else if (result == -EMFILE || result == -ENFILE || result == -ENOBUFS || result == -ENOMEM) {
+            // Out of descriptors or memory: new connections wait in the backlog while the current ones are served.
+            // Rearming right away would fail again at once, so the accept waits for a timeout, longer every time.
+            if (!more) {
+                retry_accept_later();
+            }
+        } else if (result != -EAGAIN && result != -EINTR && result != -ECONNABORTED && result != -ECANCELED) {
+            throw std::runtime_error("Unable to accept a connection on this socket.");
+        }
+    }
+
+    void retry_accept_later() {
+        accept_backoff_ms_ = std::clamp(accept_backoff_ms_ * 2, MIN_ACCEPT_BACKOFF_MS, MAX_ACCEPT_BACKOFF_MS);
+        accept_retry_timeout_.tv_sec = accept_backoff_ms_ / 1000;
+        accept_retry_timeout_.tv_nsec = (accept_backoff_ms_ % 1000) * 1000000;
+
+        struct io_uring_sqe& sqe = ring_.get_sqe();
+        sqe.opcode = IORING_OP_TIMEOUT;
+        sqe.addr = reinterpret_cast<uint64_t>(&accept_retry_timeout_);
+        sqe.len = 1;
+        sqe.user_data = user_data(Operation::AcceptRetry, listener_fd_);
+        // the accept is rearmed when the timeout completes
+        accept_armed_ = true;
+    }
+
+    void received(int fd, const struct io_uring_cqe& cqe, bool more) {
+        ConnectionState& connection = connections_[fd];
+        connection.recv_armed = more;
+
+        if (cqe.res > 0) {
+            uint16_t id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (!connection.closing) {
+                process(fd, buffers_.buffer(id), static_cast<size_t>(cqe.res));
+            }
+            buffers_.recycle(id);
+            if (!more) {
+                rearm(fd);
+            }
+        } else if (cqe.res == -ENOBUFS) {
+            // every provided buffer is in use, they are handed back before the next submit, so try again then
+            rearm(fd);
+        } else if (!connection.closing) {
+            // 0 is a disconnect, anything else an error
+            close_connection(fd);
+        }
+    }
+
+    void rearm(int fd) {
+        ConnectionState& connection = connections_[fd];
+        if (connection.open && !connection.closing && !connection.recv_armed) {
+            unarmed_.push_back(fd);
+        }
+    }
+
+    void process(int fd, char* bytes, size_t size) {
+        ConnectionState& connection = connections_[fd];
+        if (!connection.input) {
+            // nothing left over from earlier chunks, the handler reads the provided buffer directly
+            size_t consumed = on_data(fd, bytes, size);
+            if (consumed < size && !append_input(connections_[fd], bytes + consumed, size - consumed)) {
+                close_connection(fd);
+            }
+            return;
+        }
+
+        if (!append_input(connection, bytes, size)) {
+            // the message is larger than MAX_MESSAGE_SIZE, or no ring could be mapped for it
+            close_connection(fd);
+            return;
+        }
+        MirroredBuffer& input = *connection.input;
+        input.consume(on_data(fd, input.data(), input.size()));
+
+        // not kept across on_data, a handler adding sockets may grow the table
+        ConnectionState& current = connections_[fd];
+        if (input.empty()) {
+            inputs_->release(std::move(current.input));
+        }
+    }
+
+    size_t on_data(int fd, char* bytes, size_t size) {
+        int bytes_consumed;
+        if constexpr (HasBufferedOnDataMethod<MessageHandler>) {
+            bytes_consumed = handler_.on_data(fd, bytes, static_cast<int>(size), connections_[fd].output);
+        } else {
+            bytes_consumed = handler_.on_data(fd, bytes, static_cast<int>(size));
+        }
+
+        ConnectionState& connection = connections_[fd];
+        if (!connection.output.empty()) {
+            mark_pending(fd, connection);
+        }
+        return static_cast<size_t>(bytes_consumed);
+    }
+
+    // Copies unconsumed bytes behind the ones already buffered, growing the ring as EpollReactor does.
+    // Returns false if the buffered message would exceed MAX_MESSAGE_SIZE, or if no ring could be mapped (see
+    // EpollReactor::reserve_input), so that only this connection is closed.
+    bool append_input(ConnectionState& connection, const char* bytes, size_t size) {
+        try {
+            if (!connection.input) {
+                connection.input = inputs_->acquire();
+            }
+            while (connection.input->free_space() < size) {
+                if (connection.input->capacity() >= MAX_MESSAGE_SIZE) {
+                    return false;
+                }
+                connection.input = inputs_->grow(std::move(connection.input));
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        std::memcpy(connection.input->space(), bytes, size);
+        connection.input->commit(size);
+        return true;
+    }
+
+    void mark_pending(int fd, ConnectionState& connection) {
+        if (!connection.flush_pending) {
+            connection.flush_pending = true;
+            pending_flushes_.push_back(fd);
+        }
+    }
+
+    // One sendmsg request per connection with queued output. A connection has at most one send in flight, so that
+    // its bytes go out in order, output queued meanwhile is sent when that send completes.
+    void flush_pending() {
+        for (int fd : pending_flushes_) {
+            ConnectionState& connection = connections_[fd];
+            connection.flush_pending = false;
+            if (connection.open && !connection.closing && !connection.send_in_flight && !connection.output.empty()) {
+                submit_send(fd, connection);
+            }
+        }
+        pending_flushes_.clear();
+    }
+
+    void submit_send(int fd, ConnectionState& connection) {
+        if (!connection.message) {
+            connection.message = std::make_unique<struct msghdr>();
+            connection.iovecs = std::make_unique<struct iovec[]>(OutputBuffer::MAX_IOVECS);
+        }
+        *connection.message = {};
+        connection.message->msg_iov = connection.iovecs.get();
+        connection.message->msg_iovlen = connection.output.gather(connection.iovecs.get(), OutputBuffer::MAX_IOVECS);
+
+        struct io_uring_sqe& sqe = ring_.get_sqe();
+        sqe.opcode = IORING_OP_SENDMSG;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(connection.message.get());
+        sqe.msg_flags = MSG_NOSIGNAL;
+        sqe.user_data = user_data(Operation::Send, fd);
+        connection.send_in_flight = true;
+    }
+
+    void sent(int fd, int result) {
+        ConnectionState& connection = connections_[fd];
+        connection.send_in_flight = false;
+        if (connection.closing) {
+            return;
+        }
+        if (result < 0) {
+            close_connection(fd);
+            return;
+        }
+
+        connection.output.consume(static_cast<size_t>(result));
+        if (!connection.output.empty()) {
+            mark_pending(fd, connection);
+        }
+    }
+
+    // The kernel keeps a reference to the socket while a request on it is in flight, so closing the fd alone would
+    // neither end the armed recv nor send a FIN. shutdown() completes every request, and the fd is closed once the
+    // last completion came back, so it cannot be reused by a new connection while completions for it are pending.
+    void close_connection(int fd) {
+        ConnectionState& connection = connections_[fd];
+        inputs_->release(std::move(connection.input));
+        if (connection.recv_armed || connection.send_in_flight) {
+            connection.closing = true;
+            shutdown(fd, SHUT_RDWR);
+        } else {
+            finish_close(fd, connection);
+        }
+    }
+
+    void finish_close(int fd, ConnectionState& connection) {
+        connection.output.clear();
+        connection.open = false;
+        connection.closing = false;
+        close(fd);
+    }
+
+    // declared before ring_ so that they outlive it: the kernel may use them until the ring is closed
+    std::unique_ptr<BufferPool> pool_ = std::make_unique<BufferPool>(OutputBuffer::BLOCK_SIZE);
+    std::unique_ptr<MirroredBufferPool> inputs_ = std::make_unique<MirroredBufferPool>();
+    std::vector<ConnectionState> connections_;
+    BufferRing buffers_;
+    IoUring ring_;
+    MessageHandler& handler_;
+    int listener_fd_ { -1 };
+    int wakeup_fd_ { -1 };
+    uint64_t wakeup_value_ {};
+    std::atomic<bool> stopped_ { false };
+    bool accept_armed_ {};
+    long accept_backoff_ms_ {};
+    struct __kernel_timespec accept_retry_timeout_ {};
+    static constexpr long MIN_ACCEPT_BACKOFF_MS = 10;
+    static constexpr long MAX_ACCEPT_BACKOFF_MS = 1000;
+    bool wakeup_armed_ {};
+    std::vector<int> unarmed_;          // connections whose recv must be (re)armed before the next submit
+    std::vector<int> pending_flushes_;
+
+    static constexpr uint16_t BUFFER_GROUP { 0 };
+    static constexpr size_t MAX_MESSAGE_SIZE { 16 * 1024 * 1024 }; // connections sending larger messages are closed
+
+    using TCPSocket = network::TCPSocket;
+};
+
+}
@@ -1,5 +1,5 @@
 #include <gtest/gtest.h>
-#include "CustomSTL/arena.hpp"
+#include "customSTL/arena.hpp"
 
 // Test allocation, making sure the correct amount of bytes is allocated and
 // aligned, while ensuring that std::bad_alloc is thrown when all memory is used
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "customSTL/atomic_shared_ptr.hpp"
+
+namespace {
+    struct Snapshot {
+        static inline std::atomic<int> alive = 0;
+
+        int version;
+
+        explicit Snapshot(int v) : version { v } { ++alive; }
+        ~Snapshot() { --alive; }
+    };
+}
+
+// Test load/store/exchange on a single thread
+TEST(AtomicSharedPtrTest, LoadStoreExchange) {
+    {
+        CustomSTL::atomic_shared_ptr<Snapshot> config;
+        EXPECT_TRUE(config.is_lock_free());
+        EXPECT_FALSE(config.load());
+
+        config.store(CustomSTL::make_shared<Snapshot>(1));
+        auto first = config.load();
+        ASSERT_TRUE(first);
+        EXPECT_EQ(first->version, 1);
+        EXPECT_EQ(first.use_count(), 2);
+
+        auto previous = config.exchange(CustomSTL::make_shared<Snapshot>(2));
+        EXPECT_EQ(previous, first);
+        EXPECT_EQ(config.load()->version, 2);
+
+        config = nullptr;
+        EXPECT_FALSE(config.load());
+        EXPECT_EQ(Snapshot::alive, 1);
+    }
+    EXPECT_EQ(Snapshot::alive, 0);
+}
+
+// Test that compare_exchange only succeeds when expected shares ownership with the stored value
+TEST(AtomicSharedPtrTest, CompareExchange) {
+    auto v1 = CustomSTL::make_shared<Snapshot>(1);
+    CustomSTL::atomic_shared_ptr<Snapshot> config(v1);
+
+    auto unrelated = CustomSTL::make_shared<Snapshot>(1);
+    EXPECT_FALSE(config.compare_exchange_strong(unrelated, CustomSTL::make_shared<Snapshot>(2)));
+    EXPECT_EQ(unrelated, v1);
+
+    auto expected = v1;
+    EXPECT_TRUE(config.compare_exchange_strong(expected, CustomSTL::make_shared<Snapshot>(3)));
+    EXPECT_EQ(config.load()->version, 3);
+
+    CustomSTL::shared_ptr<Snapshot> empty;
+    EXPECT_FALSE(config.compare_exchange_strong(empty, nullptr));
+    EXPECT_EQ(empty->version, 3);
+}
+
+// Test that a null pointer that still owns a control block keeps its ownership while stored
+TEST(AtomicSharedPtrTest, NullPointerWithOwner) {
+    int released = 0;
+    CustomSTL::atomic_shared_ptr<Snapshot> config;
+
+    {
+        CustomSTL::shared_ptr<Snapshot> owner(static_cast<Snapshot*>(nullptr), [&](Snapshot*) { ++released; });
+        config.store(owner);
+        EXPECT_EQ(owner.use_count(), 2);
+    }
+    EXPECT_EQ(released, 0);
+
+    auto loaded = config.load();
+    EXPECT_FALSE(loaded);
+    EXPECT_EQ(loaded.use_count(), 2);
+
+    // it is not the empty value, so it only compares equal to a shared_ptr with the same owner
+    CustomSTL::shared_ptr<Snapshot> empty;
+    EXPECT_FALSE(config.compare_exchange_strong(empty, nullptr));
+    EXPECT_EQ(empty.use_count(), 3);
+    EXPECT_TRUE(config.compare_exchange_strong(loaded, nullptr));
+
+    empty = nullptr;
+    loaded = nullptr;
+    EXPECT_EQ(released, 1);
+}
+
+// Test that concurrent readers never observe a destroyed snapshot while a writer keeps publishing
+TEST(AtomicSharedPtrTest, ConcurrentReadersAndWriter) {
+    {
+        CustomSTL::atomic_shared_ptr<Snapshot> config(CustomSTL::make_shared<Snapshot>(0));
+        std::atomic<bool> done = false;
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; ++i) {
+            readers.emplace_back([&] {
+                int last_seen = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    auto snapshot = config.load();
+                    ASSERT_TRUE(snapshot);
+                    // versions are published in increasing order
+                    ASSERT_GE(snapshot->version, last_seen);
+                    last_seen = snapshot->version;
+                }
+            });
+        }
+
+        for (int version = 1; version <= 20000; ++version) {
+            config.store(CustomSTL::make_shared<Snapshot>(version));
+        }
+        done = true;
+
+        for (auto& reader : readers) {
+            reader.join();
+        }
+
+        EXPECT_EQ(config.load()->version, 20000);
+        EXPECT_EQ(Snapshot::alive, 1);
+    }
+    EXPECT_EQ(Snapshot::alive, 0);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "customSTL/distributed_shared_mutex.hpp"
+#include "customSTL/shared_lock.hpp"
+#include "customSTL/unique_lock.hpp"
+
+using Mutex = CustomSTL::distributed_shared_mutex<>;
+
+// Test that readers share the lock and exclude writers, and that the guards work like unique_lock
+TEST(DistributedSharedMutexTest, SharedAndExclusive) {
+    static_assert(CustomSTL::TimedLockable<Mutex>);
+    static_assert(CustomSTL::SharedTimedLockable<Mutex>);
+
+    Mutex mutex;
+    {
+        CustomSTL::shared_lock<Mutex> reader(mutex);
+        EXPECT_TRUE(reader.owns_lock());
+
+        std::thread other([&] {
+            CustomSTL::shared_lock<Mutex> second_reader(mutex, std::try_to_lock);
+            EXPECT_TRUE(second_reader);
+
+            CustomSTL::unique_lock<Mutex> writer(mutex, std::chrono::milliseconds(5));
+            EXPECT_FALSE(writer.owns_lock());
+        });
+        other.join();
+    }
+
+    CustomSTL::unique_lock<Mutex> writer(mutex);
+    std::thread other([&] {
+        EXPECT_FALSE(mutex.try_lock_shared());
+        CustomSTL::shared_lock<Mutex> reader(mutex, std::chrono::milliseconds(5));
+        EXPECT_FALSE(reader);
+        EXPECT_FALSE(mutex.try_lock());
+    });
+    other.join();
+
+    writer.unlock();
+    CustomSTL::shared_lock<Mutex> reader(mutex, std::defer_lock);
+    EXPECT_TRUE(reader.try_lock_for(std::chrono::milliseconds(1)));
+}
+
+// Test that a waiting writer blocks new readers, so that readers cannot starve it
+TEST(DistributedSharedMutexTest, WriterPreference) {
+    Mutex mutex;
+    mutex.lock_shared();
+
+    std::atomic<bool> acquired { false };
+    std::thread writer([&] {
+        mutex.lock();
+        acquired = true;
+        mutex.unlock();
+    });
+
+    // once the writer is waiting for us to leave, new readers are turned away
+    while (mutex.try_lock_shared()) {
+        mutex.unlock_shared();
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(acquired);
+
+    mutex.unlock_shared();
+    writer.join();
+    EXPECT_TRUE(acquired);
+}
+
+// Test that writers see a consistent state under concurrent readers and writers
+TEST(DistributedSharedMutexTest, ReadersAndWriters) {
+    Mutex mutex;
+    long a = 0;
+    long b = 0;
+    std::atomic<bool> torn { false };
+
+    constexpr int WRITERS = 2;
+    constexpr int READERS = 4;
+    constexpr int ITERATIONS = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < WRITERS; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < ITERATIONS; ++i) {
+                CustomSTL::unique_lock<Mutex> guard(mutex);
+                ++a;
+                ++b;
+            }
+        });
+    }
+    for (int t = 0; t < READERS; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < ITERATIONS; ++i) {
+                CustomSTL::shared_lock<Mutex> guard(mutex);
+                if (a != b) {
+                    torn = true;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_FALSE(torn);
+    EXPECT_EQ(a, WRITERS * ITERATIONS);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "customSTL/epoch_reclamation.hpp"
+
+namespace {
+    struct Node {
+        static inline std::atomic<int> alive = 0;
+
+        int value;
+
+        explicit Node(int v) : value { v } { ++alive; }
+        ~Node() { --alive; }
+    };
+}
+
+// Test that a node is not reclaimed while another participant is pinned
+TEST(EpochReclamationTest, PinnedReaderBlocksReclamation) {
+    {
+        CustomSTL::EpochDomain domain;
+        CustomSTL::EpochDomain::Participant reader(domain);
+        CustomSTL::EpochDomain::Participant writer(domain, 1);
+
+        {
+            auto guard = reader.pin();
+            writer.retire(new Node(1));
+            writer.reclaim();
+            writer.reclaim();
+            EXPECT_EQ(Node::alive, 1);
+            EXPECT_EQ(writer.pending(), 1uz);
+        }
+
+        // once the reader unpins, the epoch can advance twice and the node is freed
+        writer.reclaim();
+        writer.reclaim();
+        EXPECT_EQ(Node::alive, 0);
+        EXPECT_EQ(writer.pending(), 0uz);
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
+
+// Test that retired nodes can be handed back to an ObjectPool
+TEST(EpochReclamationTest, RetireToPool) {
+    CustomSTL::ObjectPool<Node> pool(1);
+    CustomSTL::EpochDomain domain;
+    CustomSTL::EpochDomain::Participant participant(domain);
+
+    Node* node = pool.acquire(1);
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(pool.acquire(2), nullptr);
+
+    participant.retire(node, pool);
+    participant.reclaim();
+    participant.reclaim();
+    EXPECT_EQ(Node::alive, 0);
+
+    Node* reused = pool.acquire(3);
+    EXPECT_EQ(reused, node);
+    pool.release(reused);
+}
+
+// Test readers traversing a shared pointer while a writer keeps replacing and retiring it
+TEST(EpochReclamationTest, ConcurrentReplace) {
+    {
+        CustomSTL::EpochDomain domain;
+        std::atomic<Node*> shared { new Node(0) };
+        std::atomic<bool> done = false;
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 3; ++i) {
+            readers.emplace_back([&] {
+                CustomSTL::EpochDomain::Participant participant(domain);
+                while (!done.load(std::memory_order_relaxed)) {
+                    auto guard = participant.pin();
+                    Node* node = shared.load(std::memory_order_acquire);
+                    ASSERT_GE(node->value, 0);
+                }
+            });
+        }
+
+        {
+            CustomSTL::EpochDomain::Participant writer(domain, 16);
+            for (int i = 1; i <= 10000; ++i) {
+                Node* old = shared.exchange(new Node(i), std::memory_order_acq_rel);
+                writer.retire(old);
+            }
+            done = true;
+            for (auto& reader : readers) {
+                reader.join();
+            }
+        }
+
+        delete shared.load();
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
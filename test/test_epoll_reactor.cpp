@@ -0,0 +1,703 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <netinet/in.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+#include "network/bufferpool.hpp"
+#include "network/epollreactor.hpp"
+#include "network/mirroredbuffer.hpp"
+#include "network/multireactor.hpp"
+#include "network/outputbuffer.hpp"
+
+namespace {
+    // consumes everything it receives and counts it
+    struct CountingHandler {
+        explicit CountingHandler(std::atomic<long>* total)
+            : total_bytes { total }
+        { }
+
+        std::atomic<long>* total_bytes;
+        long bytes = 0;
+        std::thread::id thread;
+
+        int on_data(int, void*, int size) {
+            bytes += size;
+            thread = std::this_thread::get_id();
+            total_bytes->fetch_add(size);
+            return size;
+        }
+    };
+
+    // replies to every byte it receives: "x" is echoed back, "b" answers with BIG_REPLY bytes
+    struct ReplyingHandler {
+        static constexpr size_t BIG_REPLY = 8 * 1024 * 1024;
+
+        int on_data(int, void* buf, int size, network::OutputBuffer& out) {
+            const char* bytes = static_cast<const char*>(buf);
+            for (int i = 0; i < size; ++i) {
+                if (bytes[i] == 'b') {
+                    std::vector<char> reply(BIG_REPLY, 'b');
+                    out.append(reply.data(), reply.size());
+                } else {
+                    out.append(&bytes[i], 1);
+                }
+            }
+            return size;
+        }
+    };
+
+    // messages are a 4 byte length followed by the payload, only complete messages are consumed
+    struct FramedHandler {
+        explicit FramedHandler(std::atomic<long>* messages)
+            : total_messages { messages }
+        { }
+
+        int on_data(int, void* buf, int size) {
+            const char* bytes = static_cast<const char*>(buf);
+            int consumed = 0;
+            while (size - consumed >= 4) {
+                uint32_t length;
+                std::memcpy(&length, bytes + consumed, 4);
+                if (size - consumed - 4 < static_cast<int>(length)) {
+                    break;
+                }
+                consumed += 4 + length;
+                total_messages->fetch_add(1);
+            }
+            return consumed;
+        }
+
+        std::atomic<long>* total_messages;
+    };
+
+    // counts what it receives and records the largest event batch of the reactor it runs on
+    struct BatchObservingHandler {
+        explicit BatchObservingHandler(std::atomic<long>* total)
+            : total_bytes { total }
+        { }
+
+        std::atomic<long>* total_bytes;
+        std::function<int()> batch_size;
+        int largest_batch = 0;
+
+        int on_data(int, void*, int size) {
+            largest_batch = std::max(largest_batch, batch_size());
+            total_bytes->fetch_add(size);
+            return size;
+        }
+    };
+
+    int connect_to(const std::string& port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(std::stoi(port)));
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool wait_for(const std::atomic<long>& value, long expected) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (value.load() != expected && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return value.load() == expected;
+    }
+}
+
+// Test that a reactor receives data from its clients and that stop() ends run() from another thread
+TEST(EpollReactorTest, ReceiveAndStop) {
+    std::atomic<long> total { 0 };
+    CountingHandler handler(&total);
+
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<CountingHandler> reactor(handler);
+    reactor.add_socket(server.get_fd());
+
+    std::thread loop([&] { reactor.run(server); });
+
+    int client = connect_to(server.get_port());
+    ASSERT_NE(client, -1);
+    ASSERT_EQ(send(client, "hello", 5, 0), 5);
+    EXPECT_TRUE(wait_for(total, 5));
+
+    reactor.stop();
+    loop.join();
+    close(client);
+}
+
+// Test that send() drops data for file descriptors that are not open connections of the reactor
+TEST(EpollReactorTest, SendToUnknownConnection) {
+    std::atomic<long> total { 0 };
+    CountingHandler handler(&total);
+    network::EpollReactor<CountingHandler> reactor(handler);
+
+    reactor.send(-1, "hello", 5);
+    reactor.send(1 << 20, "hello", 5);
+    int unregistered = socket(AF_INET, SOCK_STREAM, 0);
+    reactor.send(unregistered, "hello", 5);
+    EXPECT_EQ(reactor.buffer_pool().blocks_in_use(), 0u);
+    close(unregistered);
+}
+
+// Test that a busy polling reactor still receives data, blocks once its budget is spent and stops
+TEST(EpollReactorTest, BusyPoll) {
+    std::atomic<long> total { 0 };
+    CountingHandler handler(&total);
+
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<CountingHandler> reactor(handler, {
+        .busy_poll_budget = std::chrono::microseconds(200),
+        .socket_busy_poll_us = 50, // may be refused without privileges, which must not matter
+        .prefer_busy_poll = true,
+    });
+    reactor.add_socket(server.get_fd());
+
+    std::thread loop([&] { reactor.run(server); });
+
+    int client = connect_to(server.get_port());
+    ASSERT_NE(client, -1);
+    for (int round = 1; round <= 3; ++round) {
+        ASSERT_EQ(send(client, "hello", 5, 0), 5);
+        EXPECT_TRUE(wait_for(total, round * 5));
+        // long enough for the reactor to give up spinning and block
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    reactor.stop();
+    loop.join();
+    close(client);
+}
+
+// Test that the event batch grows while epoll_wait keeps filling it, within the configured bounds
+TEST(EpollReactorTest, AdaptiveEventBatch) {
+    std::atomic<long> total { 0 };
+    BatchObservingHandler handler(&total);
+
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<BatchObservingHandler> reactor(handler, { .min_events = 8, .max_events = 32 });
+    handler.batch_size = [&] { return reactor.event_batch_size(); };
+    reactor.add_socket(server.get_fd());
+    EXPECT_EQ(reactor.event_batch_size(), 8);
+
+    // every connection is accepted in one go and has data waiting, so the first waits return full batches
+    constexpr int CLIENTS = 100;
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        int client = connect_to(server.get_port());
+        ASSERT_NE(client, -1);
+        ASSERT_EQ(send(client, "x", 1, 0), 1);
+        clients.push_back(client);
+    }
+
+    std::thread loop([&] { reactor.run(server); });
+    EXPECT_TRUE(wait_for(total, CLIENTS));
+    reactor.stop();
+    loop.join();
+    EXPECT_EQ(handler.largest_batch, 32);
+
+    EXPECT_THROW(network::EpollReactor<BatchObservingHandler>(handler, { .min_events = 8, .max_events = 4 }),
+                 std::invalid_argument);
+    for (int client : clients) {
+        close(client);
+    }
+}
+
+// Test that connections receiving nothing for the idle timeout are closed, and that active ones stay open
+TEST(EpollReactorTest, IdleTimeout) {
+    std::atomic<long> total { 0 };
+    CountingHandler handler(&total);
+
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<CountingHandler> reactor(handler, { .idle_timeout = std::chrono::milliseconds(100) });
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    int active = connect_to(server.get_port());
+    int silent = connect_to(server.get_port());
+    ASSERT_NE(active, -1);
+    ASSERT_NE(silent, -1);
+    ASSERT_EQ(send(silent, "x", 1, 0), 1);
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(send(active, "x", 1, 0), 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_TRUE(wait_for(total, 21));
+
+    // the reactor closed the silent connection, the peer reads end of stream
+    char byte;
+    EXPECT_EQ(recv(silent, &byte, 1, 0), 0);
+    EXPECT_EQ(recv(active, &byte, 1, MSG_DONTWAIT), -1);
+    EXPECT_EQ(errno, EAGAIN);
+
+    reactor.stop();
+    loop.join();
+    EXPECT_EQ(reactor.timers().size(), 1u);
+    close(active);
+    close(silent);
+}
+
+// Test that metrics compile away unless CUSTOMSTL_REACTOR_METRICS is defined
+TEST(EpollReactorTest, MetricsDisabled) {
+    static_assert(!network::ReactorMetrics::enabled);
+    static_assert(std::is_empty_v<network::ReactorMetrics>);
+
+    std::atomic<long> total { 0 };
+    CountingHandler handler(&total);
+    network::EpollReactor<CountingHandler> reactor(handler);
+    network::ReactorStats stats = reactor.metrics();
+    EXPECT_EQ(stats.events_per_wait.count, 0u);
+    EXPECT_EQ(stats.accepted, 0u);
+}
+
+// Test that the reactors of a MultiReactor share the port and each run with their own handler on their own thread
+TEST(MultiReactorTest, ShardsConnections) {
+    std::atomic<long> total { 0 };
+    network::MultiReactor<CountingHandler> reactors("0", 2, [&](size_t) { return CountingHandler(&total); });
+    ASSERT_EQ(reactors.size(), 2u);
+    reactors.start();
+    EXPECT_THROW(reactors.start(), std::logic_error);
+
+    constexpr int CLIENTS = 16;
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        int client = connect_to(reactors.get_port());
+        ASSERT_NE(client, -1);
+        ASSERT_EQ(send(client, "ping", 4, 0), 4);
+        clients.push_back(client);
+    }
+    EXPECT_TRUE(wait_for(total, CLIENTS * 4));
+
+    reactors.stop();
+    reactors.join();
+
+    EXPECT_EQ(reactors.handler(0).bytes + reactors.handler(1).bytes, CLIENTS * 4);
+    if (reactors.handler(0).bytes > 0 && reactors.handler(1).bytes > 0) {
+        EXPECT_NE(reactors.handler(0).thread, reactors.handler(1).thread);
+    }
+    for (int client : clients) {
+        close(client);
+    }
+}
+
+// Test that many small appends are coalesced and sent in order by a single flush
+TEST(OutputBufferTest, CoalescesWrites) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    network::OutputBuffer out;
+    std::string expected;
+    for (int i = 0; i < 1000; ++i) {
+        std::string message = std::to_string(i) + ";";
+        out.append(message.data(), message.size());
+        expected += message;
+    }
+    std::string large(3 * network::OutputBuffer::BLOCK_SIZE, 'L');
+    out.append(large.data(), large.size());
+    expected += large;
+    EXPECT_EQ(out.size(), expected.size());
+
+    EXPECT_EQ(out.flush(fds[0]), network::OutputBuffer::FlushResult::Done);
+    EXPECT_TRUE(out.empty());
+
+    std::string received(expected.size(), '\0');
+    size_t offset = 0;
+    while (offset < received.size()) {
+        ssize_t rc = recv(fds[1], received.data() + offset, received.size() - offset, 0);
+        ASSERT_GT(rc, 0);
+        offset += rc;
+    }
+    EXPECT_EQ(received, expected);
+
+    close(fds[1]);
+    out.append("x", 1);
+    EXPECT_EQ(out.flush(fds[0]), network::OutputBuffer::FlushResult::Error);
+    close(fds[0]);
+}
+
+// Test that replies are sent back, including one much larger than the socket buffer which needs EPOLLOUT
+TEST(EpollReactorTest, BufferedReplies) {
+    ReplyingHandler handler;
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<ReplyingHandler> reactor(handler);
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    int client = connect_to(server.get_port());
+    ASSERT_NE(client, -1);
+    ASSERT_EQ(send(client, "xbx", 3, 0), 3);
+
+    // let the reactor fill the socket buffers before we start reading
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    size_t expected = ReplyingHandler::BIG_REPLY + 2;
+    std::vector<char> received(expected);
+    size_t offset = 0;
+    while (offset < expected) {
+        ssize_t rc = recv(client, received.data() + offset, expected - offset, 0);
+        ASSERT_GT(rc, 0);
+        offset += rc;
+    }
+    EXPECT_EQ(received.front(), 'x');
+    EXPECT_EQ(received[1], 'b');
+    EXPECT_EQ(received[expected - 2], 'b');
+    EXPECT_EQ(received.back(), 'x');
+
+    reactor.stop();
+    loop.join();
+    close(client);
+}
+
+// Test that a connection whose peer does not read is closed once its queued output passes the high-water mark
+TEST(EpollReactorTest, QueuedOutputLimit) {
+    ReplyingHandler handler;
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<ReplyingHandler>::Options options;
+    options.max_queued_output = 1024 * 1024;
+    network::EpollReactor<ReplyingHandler> reactor(handler, options);
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    // a small receive buffer, so that most of the reply has to wait in the reactor
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    int receive_buffer = 64 * 1024;
+    setsockopt(client, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+    timeval timeout { 5, 0 };
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(std::stoi(server.get_port())));
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_EQ(send(client, "b", 1, 0), 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    // only what the socket buffers took before the connection was closed arrives, followed by the end of stream
+    size_t received = 0;
+    std::vector<char> buffer(65536);
+    ssize_t rc;
+    while ((rc = recv(client, buffer.data(), buffer.size(), 0)) > 0) {
+        received += static_cast<size_t>(rc);
+    }
+    EXPECT_EQ(rc, 0);
+    EXPECT_LT(received, ReplyingHandler::BIG_REPLY);
+    EXPECT_EQ(reactor.buffer_pool().blocks_in_use(), 0u);
+
+    reactor.stop();
+    loop.join();
+    close(client);
+}
+
+// Test that the pool grows by slabs and gives empty slabs back, keeping a single empty one
+TEST(BufferPoolTest, GrowsAndShrinks) {
+    network::BufferPool pool(1024, 16);
+    std::vector<char*> blocks;
+    for (int i = 0; i < 100; ++i) {
+        blocks.push_back(pool.allocate());
+        std::memset(blocks.back(), i, 1024);
+    }
+    EXPECT_EQ(pool.blocks_in_use(), 100u);
+    EXPECT_EQ(pool.slab_count(), 7u);
+
+    for (char* block : blocks) {
+        pool.deallocate(block);
+    }
+    EXPECT_EQ(pool.blocks_in_use(), 0u);
+    EXPECT_EQ(pool.slab_count(), 1u);
+
+    // the remaining slab is reused
+    char* block = pool.allocate();
+    EXPECT_EQ(pool.slab_count(), 1u);
+    pool.deallocate(block);
+}
+
+// Test that freeing and allocating a block of a full slab over and over does not list the slab again every time
+TEST(BufferPoolTest, CyclesAtSlabBoundary) {
+    network::BufferPool pool(64, 4);
+    std::vector<char*> blocks;
+    for (int i = 0; i < 4; ++i) {
+        blocks.push_back(pool.allocate());
+    }
+    EXPECT_EQ(pool.available_slab_count(), 0u);
+
+    for (int i = 0; i < 100000; ++i) {
+        pool.deallocate(blocks.back());
+        EXPECT_LE(pool.available_slab_count(), 1u);
+        blocks.back() = pool.allocate();
+    }
+    EXPECT_EQ(pool.available_slab_count(), 0u);
+    EXPECT_EQ(pool.slab_count(), 1u);
+
+    // a fifth block takes a new slab, which stays listed while it has free blocks
+    blocks.push_back(pool.allocate());
+    EXPECT_EQ(pool.slab_count(), 2u);
+    EXPECT_EQ(pool.available_slab_count(), 1u);
+    for (char* block : blocks) {
+        pool.deallocate(block);
+    }
+    // the spare empty slab is kept apart from the partially used ones
+    EXPECT_EQ(pool.slab_count(), 1u);
+    EXPECT_EQ(pool.available_slab_count(), 0u);
+}
+
+// Test that blocks come from partially used slabs before the empty spare, so that the spare can still be freed
+TEST(BufferPoolTest, FillsPartialSlabsFirst) {
+    network::BufferPool pool(64, 4);
+    std::vector<char*> first;
+    for (int i = 0; i < 4; ++i) {
+        first.push_back(pool.allocate());
+    }
+    char* second = pool.allocate();
+    for (char* block : first) {
+        pool.deallocate(block); // the first slab becomes the spare
+    }
+    ASSERT_EQ(pool.slab_count(), 2u);
+
+    auto in_first_slab = [&](char* block) {
+        return std::find(first.begin(), first.end(), block) != first.end();
+    };
+    std::vector<char*> blocks;
+    for (int i = 0; i < 3; ++i) {
+        blocks.push_back(pool.allocate());
+        EXPECT_FALSE(in_first_slab(blocks.back()));
+    }
+    // the second slab is full now, the spare serves the next block
+    blocks.push_back(pool.allocate());
+    EXPECT_TRUE(in_first_slab(blocks.back()));
+    EXPECT_EQ(pool.slab_count(), 2u);
+
+    // once the spare's block is back, emptying the second slab keeps it as the spare and frees nothing else
+    pool.deallocate(blocks.back());
+    blocks.pop_back();
+    blocks.push_back(second);
+    for (char* block : blocks) {
+        pool.deallocate(block);
+    }
+    EXPECT_EQ(pool.slab_count(), 1u);
+    EXPECT_EQ(pool.blocks_in_use(), 0u);
+}
+
+// Test connections whose fd is above the size of the connection table, and that idle connections hold no buffers
+TEST(EpollReactorTest, HighFileDescriptors) {
+    // push the next fds past 1000 (the old fixed table size)
+    std::vector<int> placeholders;
+    while (placeholders.empty() || placeholders.back() < 1100) {
+        int fd = open("/dev/null", O_RDONLY);
+        ASSERT_NE(fd, -1);
+        placeholders.push_back(fd);
+    }
+
+    std::atomic<long> messages { 0 };
+    FramedHandler handler(&messages);
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<FramedHandler> reactor(handler);
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    constexpr int CLIENTS = 50;
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        int client = connect_to(server.get_port());
+        ASSERT_NE(client, -1);
+        // a partial message: the connection keeps its input buffer until the rest arrives
+        uint32_t length = 3;
+        ASSERT_EQ(send(client, &length, 4, 0), 4);
+        ASSERT_EQ(send(client, "ab", 2, 0), 2);
+        clients.push_back(client);
+    }
+    for (int client : clients) {
+        ASSERT_EQ(send(client, "c", 1, 0), 1);
+    }
+    EXPECT_TRUE(wait_for(messages, CLIENTS));
+
+    reactor.stop();
+    loop.join();
+    EXPECT_EQ(reactor.buffer_pool().blocks_in_use(), 0u);
+    EXPECT_EQ(reactor.input_buffers().in_use(), 0u);
+
+    for (int fd : clients) {
+        close(fd);
+    }
+    for (int fd : placeholders) {
+        close(fd);
+    }
+}
+
+// Test that a message larger than a pool block is received in a grown buffer
+TEST(EpollReactorTest, OversizedMessage) {
+    std::atomic<long> messages { 0 };
+    FramedHandler handler(&messages);
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<FramedHandler> reactor(handler);
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    int client = connect_to(server.get_port());
+    ASSERT_NE(client, -1);
+    std::vector<char> message(4 + 1024 * 1024, 'm');
+    uint32_t length = message.size() - 4;
+    std::memcpy(message.data(), &length, 4);
+    size_t offset = 0;
+    while (offset < message.size()) {
+        ssize_t rc = send(client, message.data() + offset, message.size() - offset, 0);
+        ASSERT_GT(rc, 0);
+        offset += rc;
+    }
+    EXPECT_TRUE(wait_for(messages, 1));
+
+    reactor.stop();
+    loop.join();
+    EXPECT_EQ(reactor.buffer_pool().blocks_in_use(), 0u);
+    EXPECT_EQ(reactor.input_buffers().in_use(), 0u);
+    close(client);
+}
+
+// Test that a connection whose input ring cannot be mapped is closed, and that the reactor keeps serving others
+TEST(EpollReactorTest, InputMappingFailure) {
+    std::atomic<long> messages { 0 };
+    FramedHandler handler(&messages);
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<FramedHandler> reactor(handler);
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    // a complete message, then the start of a large one: the connection holds a ring
+    int client = connect_to(server.get_port());
+    ASSERT_NE(client, -1);
+    std::vector<char> message(4 + 1024 * 1024, 'm');
+    uint32_t length = 1;
+    std::memcpy(message.data(), &length, 4);
+    ASSERT_EQ(send(client, message.data(), 5, 0), 5);
+    length = message.size() - 4;
+    std::memcpy(message.data(), &length, 4);
+    ASSERT_EQ(send(client, message.data(), 100, 0), 100);
+    EXPECT_TRUE(wait_for(messages, 1));
+
+    // no more file descriptors, so the memfd of a larger ring cannot be created
+    rlimit limits;
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limits), 0);
+    int lowest_free = open("/dev/null", O_RDONLY);
+    ASSERT_NE(lowest_free, -1);
+    close(lowest_free);
+    rlimit lowered = limits;
+    lowered.rlim_cur = lowest_free;
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &lowered), 0);
+
+    size_t offset = 100;
+    while (offset < message.size()) {
+        ssize_t rc = send(client, message.data() + offset, message.size() - offset, MSG_NOSIGNAL);
+        if (rc <= 0) {
+            break;
+        }
+        offset += rc;
+    }
+    char byte;
+    EXPECT_LE(recv(client, &byte, 1, 0), 0);
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limits), 0);
+
+    int other = connect_to(server.get_port());
+    ASSERT_NE(other, -1);
+    length = 1;
+    std::memcpy(message.data(), &length, 4);
+    ASSERT_EQ(send(other, message.data(), 5, 0), 5);
+    EXPECT_TRUE(wait_for(messages, 2));
+
+    reactor.stop();
+    loop.join();
+    EXPECT_EQ(reactor.input_buffers().in_use(), 0u);
+    close(client);
+    close(other);
+}
+
+// Test that bytes wrapping around the end of the ring are contiguous, and written through either mapping
+TEST(MirroredBufferTest, WrapsAround) {
+    network::MirroredBuffer ring(1000);
+    size_t capacity = ring.capacity();
+    EXPECT_EQ(capacity % static_cast<size_t>(sysconf(_SC_PAGESIZE)), 0u);
+    EXPECT_GE(capacity, 1000u);
+
+    std::memset(ring.space(), 'a', capacity - 10);
+    ring.commit(capacity - 10);
+    ring.consume(capacity - 20);
+    EXPECT_EQ(ring.size(), 10u);
+    EXPECT_EQ(ring.free_space(), capacity - 10);
+
+    // 30 bytes from 10 before the end of the ring to 20 past its start
+    std::memcpy(ring.space(), "0123456789abcdefghijklmnopqrst", 30);
+    ring.commit(30);
+    EXPECT_EQ(std::string(ring.data(), ring.size()), std::string(10, 'a') + "0123456789abcdefghijklmnopqrst");
+    ring.consume(20);
+    EXPECT_EQ(std::string(ring.data(), ring.size()), "abcdefghijklmnopqrst");
+    // the wrapped bytes live at the start of the first mapping
+    EXPECT_EQ(ring.data() + ring.size(), ring.space());
+
+    ring.consume(20);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.free_space(), capacity);
+}
+
+// Test that released rings are reused by size, within the spare budget, and that growing keeps the buffered bytes
+TEST(MirroredBufferTest, PoolReusesAndGrows) {
+    network::MirroredBufferPool pool(4096, 3 * 4096);
+    auto ring = pool.acquire();
+    const network::MirroredBuffer* first = ring.get();
+    std::memcpy(ring->space(), "partial", 7);
+    ring->commit(7);
+
+    ring = pool.grow(std::move(ring));
+    const network::MirroredBuffer* grown = ring.get();
+    EXPECT_EQ(ring->capacity(), 2 * pool.capacity());
+    EXPECT_EQ(std::string(ring->data(), ring->size()), "partial");
+    EXPECT_EQ(pool.in_use(), 1u);
+    EXPECT_EQ(pool.spare_bytes(), 4096u);
+
+    pool.release(std::move(ring));
+    EXPECT_EQ(pool.in_use(), 0u);
+    EXPECT_EQ(pool.spare_bytes(), 3 * 4096u);
+
+    auto reused = pool.acquire();
+    EXPECT_EQ(reused.get(), first);
+    EXPECT_TRUE(reused->empty());
+    reused = pool.grow(std::move(reused));
+    EXPECT_EQ(reused.get(), grown);
+    EXPECT_TRUE(reused->empty());
+
+    // over budget: a 4 page ring is not kept
+    reused = pool.grow(std::move(reused));
+    EXPECT_EQ(reused->capacity(), 4 * pool.capacity());
+    pool.release(std::move(reused));
+    EXPECT_EQ(pool.spare_bytes(), 3 * 4096u);
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "customSTL/futex_mutex.hpp"
+#include "customSTL/lock_guard.hpp"
+#include "customSTL/unique_lock.hpp"
+
+// Test that futex_mutex is a single word that works with the timed unique_lock constructors
+TEST(FutexMutexTest, Requirements) {
+    static_assert(CustomSTL::TimedLockable<CustomSTL::futex_mutex>);
+    static_assert(sizeof(CustomSTL::futex_mutex) == sizeof(uint32_t));
+
+    CustomSTL::futex_mutex mutex;
+    CustomSTL::unique_lock<CustomSTL::futex_mutex> guard(mutex);
+    EXPECT_FALSE(mutex.try_lock());
+
+    std::thread other([&] {
+        CustomSTL::unique_lock<CustomSTL::futex_mutex> for_duration(mutex, std::chrono::milliseconds(5));
+        EXPECT_FALSE(for_duration);
+        CustomSTL::unique_lock<CustomSTL::futex_mutex> until_time(mutex, std::chrono::system_clock::now() + std::chrono::milliseconds(5));
+        EXPECT_FALSE(until_time);
+    });
+    other.join();
+
+    guard.unlock();
+    EXPECT_TRUE(guard.try_lock_for(std::chrono::milliseconds(1)));
+}
+
+// Test that a timed waiter sleeps until the deadline and gets the lock if it is released in time
+TEST(FutexMutexTest, TimedWait) {
+    CustomSTL::futex_mutex mutex;
+    mutex.lock();
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread timed_out([&] { EXPECT_FALSE(mutex.try_lock_for(std::chrono::milliseconds(20))); });
+    timed_out.join();
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    std::atomic<bool> acquired { false };
+    std::thread waiter([&] {
+        acquired = mutex.try_lock_for(std::chrono::seconds(10));
+        mutex.unlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    mutex.unlock();
+    waiter.join();
+    EXPECT_TRUE(acquired);
+    EXPECT_TRUE(mutex.try_lock());
+    mutex.unlock();
+}
+
+// Test mutual exclusion with sleeping waiters
+TEST(FutexMutexTest, MutualExclusion) {
+    CustomSTL::futex_mutex mutex;
+    long counter = 0;
+
+    constexpr int THREADS = 8;
+    constexpr int INCREMENTS = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < INCREMENTS; ++i) {
+                CustomSTL::lock_guard<CustomSTL::futex_mutex> guard(mutex);
+                ++counter;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(counter, THREADS * INCREMENTS);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "customSTL/hazard_pointer.hpp"
+
+namespace {
+    struct Node {
+        static inline std::atomic<int> alive = 0;
+
+        int value;
+
+        explicit Node(int v) : value { v } { ++alive; }
+        ~Node() { --alive; }
+    };
+}
+
+// Test that only nodes that are protected by a hazard pointer survive a scan
+TEST(HazardPointerTest, ProtectedNodeSurvivesScan) {
+    {
+        CustomSTL::HazardPointerDomain<> domain;
+        CustomSTL::HazardPointerDomain<>::Participant reader(domain);
+        CustomSTL::HazardPointerDomain<>::Participant writer(domain);
+
+        std::atomic<Node*> shared { new Node(1) };
+        {
+            auto guard = reader.make_guard();
+            Node* protected_node = guard.protect(shared);
+
+            writer.retire(shared.exchange(new Node(2)));
+            writer.retire(shared.exchange(new Node(3)));
+            writer.scan();
+
+            // node 2 was not protected, node 1 still is
+            EXPECT_EQ(writer.pending(), 1uz);
+            EXPECT_EQ(protected_node->value, 1);
+        }
+
+        writer.scan();
+        EXPECT_EQ(writer.pending(), 0uz);
+        delete shared.load();
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
+
+// Test that a participant only hands out as many guards as it has slots
+TEST(HazardPointerTest, GuardSlots) {
+    CustomSTL::HazardPointerDomain<2> domain;
+    CustomSTL::HazardPointerDomain<2>::Participant participant(domain);
+
+    auto first = participant.make_guard();
+    {
+        auto second = participant.make_guard();
+        EXPECT_THROW(participant.make_guard(), std::runtime_error);
+    }
+    // the slot is returned once the guard is destroyed
+    auto third = participant.make_guard();
+}
+
+// Test readers protecting a shared pointer while a writer keeps replacing and retiring it
+TEST(HazardPointerTest, ConcurrentReplace) {
+    {
+        CustomSTL::HazardPointerDomain<> domain;
+        std::atomic<Node*> shared { new Node(0) };
+        std::atomic<bool> done = false;
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 3; ++i) {
+            readers.emplace_back([&] {
+                CustomSTL::HazardPointerDomain<>::Participant participant(domain);
+                auto guard = participant.make_guard();
+                while (!done.load(std::memory_order_relaxed)) {
+                    Node* node = guard.protect(shared);
+                    ASSERT_GE(node->value, 0);
+                }
+            });
+        }
+
+        {
+            CustomSTL::HazardPointerDomain<>::Participant writer(domain, 16);
+            for (int i = 1; i <= 10000; ++i) {
+                writer.retire(shared.exchange(new Node(i), std::memory_order_acq_rel));
+            }
+            done = true;
+            for (auto& reader : readers) {
+                reader.join();
+            }
+        }
+
+        delete shared.load();
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <memory>
+#include <thread>
+#include "customSTL/inplace_function.hpp"
+#include "customSTL/spscqueue.hpp"
+
+// Test that captures are stored inline and copies/moves keep their own state
+TEST(InplaceFunctionTest, CallCopyAndMove) {
+    int calls = 0;
+    CustomSTL::inplace_function<int(int)> add = [&calls, offset = 10](int x) { ++calls; return x + offset; };
+    EXPECT_TRUE(add);
+    EXPECT_EQ(add(1), 11);
+
+    auto copy = add;
+    EXPECT_EQ(copy(2), 12);
+
+    CustomSTL::inplace_function<int(int)> moved = std::move(add);
+    EXPECT_FALSE(add);
+    EXPECT_EQ(moved(3), 13);
+    EXPECT_EQ(calls, 3);
+
+    moved = [](int x) { return x * 2; };
+    EXPECT_EQ(moved(4), 8);
+
+    moved = nullptr;
+    EXPECT_FALSE(moved);
+    EXPECT_THROW(moved(1), std::bad_function_call);
+}
+
+// Test that captures are destroyed exactly once
+TEST(InplaceFunctionTest, CaptureLifetime) {
+    auto counter = std::make_shared<int>(0);
+    {
+        CustomSTL::inplace_function<void()> f = [counter] { ++*counter; };
+        EXPECT_EQ(counter.use_count(), 2);
+        auto g = f;
+        EXPECT_EQ(counter.use_count(), 3);
+        f = std::move(g);
+        EXPECT_EQ(counter.use_count(), 2);
+        f();
+    }
+    EXPECT_EQ(*counter, 1);
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+// Test that move-only callables can be posted through SPSCQueue
+TEST(InplaceFunctionTest, MoveOnlyThroughSPSCQueue) {
+    using Task = CustomSTL::inplace_move_only_function<int(), 32>;
+    static_assert(!std::is_copy_constructible_v<Task>);
+
+    CustomSTL::SPSCQueue<Task, 16> queue;
+    constexpr int TASKS = 1000;
+
+    std::thread producer([&] {
+        for (int i = 0; i < TASKS; ++i) {
+            Task task = [value = std::make_unique<int>(i)] { return *value; };
+            while (!queue.push(std::move(task))) { }
+        }
+    });
+
+    long long sum = 0;
+    for (int received = 0; received < TASKS; ) {
+        Task task;
+        if (queue.pop(task)) {
+            sum += task();
+            ++received;
+        }
+    }
+    producer.join();
+
+    EXPECT_EQ(sum, static_cast<long long>(TASKS) * (TASKS - 1) / 2);
+}
+
+// Test the capacity boundary
+TEST(InplaceFunctionTest, Capacity) {
+    std::array<char, 24> payload {};
+    payload[23] = 5;
+    CustomSTL::inplace_function<int(), 24> f = [payload] { return payload[23]; };
+    EXPECT_EQ(f(), 5);
+    EXPECT_EQ(f.capacity(), 24u);
+    // [payload, extra = 1] { } would not compile: the capture is larger than the buffer
+}
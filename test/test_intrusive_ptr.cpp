@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "customSTL/intrusive_ptr.hpp"
+#include "customSTL/object_pool.hpp"
+
+namespace {
+    struct Message : CustomSTL::ref_counted<Message> {
+        static inline int alive = 0;
+
+        int id;
+
+        explicit Message(int i) : id { i } { ++alive; }
+        ~Message() { --alive; }
+    };
+
+    struct LocalMessage : CustomSTL::ref_counted<LocalMessage, CustomSTL::local_count_policy> {
+        int id = 0;
+    };
+
+    // returns itself to the pool it was acquired from instead of being deleted
+    struct PooledMessage : CustomSTL::ref_counted<PooledMessage> {
+        CustomSTL::ObjectPool<PooledMessage>* pool;
+        int id;
+
+        PooledMessage(CustomSTL::ObjectPool<PooledMessage>* p, int i) : pool { p }, id { i } { }
+
+        void on_last_release() noexcept { pool->release(this); }
+    };
+}
+
+// Test that intrusive_ptr is the size of a raw pointer
+TEST(IntrusivePtrTest, Size) {
+    EXPECT_EQ(sizeof(CustomSTL::intrusive_ptr<Message>), sizeof(Message*));
+}
+
+// Test that copies share the embedded count and the last release deletes the object
+TEST(IntrusivePtrTest, CopyMoveAndRelease) {
+    {
+        auto p1 = CustomSTL::make_intrusive<Message>(1);
+        EXPECT_EQ(p1->use_count(), 1u);
+        {
+            CustomSTL::intrusive_ptr<Message> p2 = p1;
+            EXPECT_EQ(p1->use_count(), 2u);
+            EXPECT_EQ(p2, p1);
+        }
+        EXPECT_EQ(p1->use_count(), 1u);
+
+        CustomSTL::intrusive_ptr<Message> p3 = std::move(p1);
+        EXPECT_FALSE(p1);
+        EXPECT_EQ(p3->id, 1);
+
+        // detach/adopt round trip keeps the count unchanged
+        Message* raw = p3.detach();
+        EXPECT_EQ(raw->use_count(), 1u);
+        CustomSTL::intrusive_ptr<Message> p4(raw, false);
+        EXPECT_EQ(p4->use_count(), 1u);
+    }
+    EXPECT_EQ(Message::alive, 0);
+
+    auto local = CustomSTL::make_intrusive<LocalMessage>();
+    auto local_copy = local;
+    EXPECT_EQ(local->use_count(), 2u);
+}
+
+// Test that the last release hook returns objects to their pool
+TEST(IntrusivePtrTest, ReleaseToPool) {
+    CustomSTL::ObjectPool<PooledMessage> pool(1);
+    {
+        CustomSTL::intrusive_ptr<PooledMessage> p(pool.acquire(&pool, 7));
+        ASSERT_TRUE(p);
+        EXPECT_EQ(p->id, 7);
+        EXPECT_EQ(pool.acquire(&pool, 8), nullptr);
+    }
+
+    // the only slot is available again
+    CustomSTL::intrusive_ptr<PooledMessage> p(pool.acquire(&pool, 9));
+    ASSERT_TRUE(p);
+    EXPECT_EQ(p->id, 9);
+}
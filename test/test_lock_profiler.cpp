@@ -0,0 +1,96 @@
+#define CUSTOMSTL_LOCK_PROFILING
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <mutex>
+#include <source_location>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "customSTL/lock_guard.hpp"
+#include "customSTL/lock_profiler.hpp"
+#include "customSTL/unique_lock.hpp"
+
+namespace {
+    const CustomSTL::lock_profiling::SiteStats* find_site(const std::vector<CustomSTL::lock_profiling::SiteStats>& stats, uint32_t line) {
+        auto it = std::find_if(stats.begin(), stats.end(), [&](const auto& site) {
+            return site.line == line && site.file == std::source_location::current().file_name();
+        });
+        return it == stats.end() ? nullptr : &*it;
+    }
+}
+
+// Test that acquisitions from several threads, including exited ones, are aggregated per lock site
+TEST(LockProfilerTest, CountsPerSite) {
+    std::mutex mutex;
+    constexpr int THREADS = 4;
+    constexpr int ITERATIONS = 1000;
+
+    uint32_t guard_line = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < ITERATIONS; ++i) {
+                CustomSTL::lock_guard<std::mutex> guard(mutex); guard_line = std::source_location::current().line();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto stats = CustomSTL::lock_profiling::snapshot();
+    const auto* site = find_site(stats, guard_line);
+    ASSERT_NE(site, nullptr);
+    EXPECT_EQ(site->acquisitions, THREADS * ITERATIONS);
+    EXPECT_EQ(site->failed_attempts, 0u);
+    EXPECT_GT(site->hold_cycles, 0u);
+    EXPECT_GE(site->hold_cycles, site->max_hold_cycles);
+    EXPECT_GE(site->wait_cycles, site->max_wait_cycles);
+}
+
+// Test that unique_lock records failed attempts and the hold time until unlock
+TEST(LockProfilerTest, UniqueLock) {
+    std::mutex mutex;
+    CustomSTL::unique_lock<std::mutex> holder(mutex); uint32_t holder_line = std::source_location::current().line();
+
+    uint32_t try_line = 0;
+    std::thread other([&] {
+        CustomSTL::unique_lock<std::mutex> attempt(mutex, std::try_to_lock); try_line = std::source_location::current().line();
+        EXPECT_FALSE(attempt);
+    });
+    other.join();
+    holder.unlock();
+
+    auto stats = CustomSTL::lock_profiling::snapshot();
+    const auto* held = find_site(stats, holder_line);
+    const auto* failed = find_site(stats, try_line);
+    ASSERT_NE(held, nullptr);
+    ASSERT_NE(failed, nullptr);
+    EXPECT_EQ(held->acquisitions, 1u);
+    EXPECT_GT(held->hold_cycles, 0u);
+    EXPECT_EQ(failed->acquisitions, 0u);
+    EXPECT_EQ(failed->failed_attempts, 1u);
+
+    std::ostringstream out;
+    CustomSTL::lock_profiling::dump(out);
+    EXPECT_NE(out.str().find(std::to_string(holder_line)), std::string::npos);
+}
+
+// Test that release() ends the hold time like unlock() does, and that a site never converts to a lock
+TEST(LockProfilerTest, Release) {
+    static_assert(!std::is_convertible_v<std::source_location, CustomSTL::unique_lock<std::mutex>>);
+
+    std::mutex mutex;
+    CustomSTL::unique_lock<std::mutex> guard(mutex); uint32_t guard_line = std::source_location::current().line();
+    std::mutex* released = guard.release();
+    EXPECT_EQ(released, &mutex);
+    EXPECT_FALSE(guard.owns_lock());
+    released->unlock();
+
+    auto stats = CustomSTL::lock_profiling::snapshot();
+    const auto* site = find_site(stats, guard_line);
+    ASSERT_NE(site, nullptr);
+    EXPECT_EQ(site->acquisitions, 1u);
+    EXPECT_GT(site->hold_cycles, 0u);
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <filesystem>
+#include <utility>
+#include "customSTL/mapped_vector.hpp"
+
+namespace {
+    struct Instrument {
+        uint64_t id;
+        double tick_size;
+    };
+
+    std::string temp_path(const char* name) {
+        auto path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove(path);
+        return path.string();
+    }
+}
+
+// Test that pushing past the capacity grows the file and keeps previous elements
+TEST(MappedVectorTest, GrowAndAccess) {
+    std::string path = temp_path("customstl_mapped_vector_grow.bin");
+    CustomSTL::mapped_vector<int> vec(path);
+    EXPECT_EQ(vec.size(), 0uz);
+    EXPECT_EQ(vec.capacity(), 1uz);
+
+    for (int i = 0; i < 100; ++i) {
+        vec.push_back(i);
+    }
+
+    EXPECT_EQ(vec.size(), 100uz);
+    EXPECT_EQ(vec.capacity(), 128uz);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(vec[i], i);
+    }
+
+    vec.pop_back();
+    EXPECT_EQ(vec.size(), 99uz);
+
+    std::filesystem::remove(path);
+}
+
+// Test pushing an element of the vector itself while it is full, so that growing remaps the storage it lives in
+TEST(MappedVectorTest, PushOwnElementAtCapacity) {
+    std::string path = temp_path("customstl_mapped_vector_self.bin");
+    CustomSTL::mapped_vector<Instrument> vec(path);
+    vec.push_back({ 7, 0.25 });
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_EQ(vec.size(), vec.capacity());
+        size_t size = vec.size();
+        for (size_t j = 0; j < size; ++j) {
+            vec.push_back(vec[0]);
+        }
+    }
+
+    EXPECT_EQ(vec.size(), 1uz << 20);
+    EXPECT_EQ(vec[vec.size() - 1].id, 7u);
+    EXPECT_DOUBLE_EQ(vec[vec.size() - 1].tick_size, 0.25);
+
+    // a moved from vector is empty
+    CustomSTL::mapped_vector<Instrument> moved = std::move(vec);
+    EXPECT_EQ(vec.size(), 0uz);
+    EXPECT_EQ(vec.capacity(), 0uz);
+    EXPECT_TRUE(vec.empty());
+    EXPECT_EQ(moved.size(), 1uz << 20);
+
+    std::filesystem::remove(path);
+}
+
+// Test that elements written by one mapping are visible when the file is reopened read only
+TEST(MappedVectorTest, ReopenReadOnly) {
+    std::string path = temp_path("customstl_mapped_vector_reopen.bin");
+    {
+        CustomSTL::mapped_vector<Instrument> vec(path, 4);
+        vec.push_back({ 1, 0.01 });
+        vec.push_back({ 2, 0.5 });
+        vec.flush();
+    }
+
+    auto lazy = CustomSTL::mapped_vector<Instrument>::open_read_only(path);
+    ASSERT_EQ(lazy.size(), 2uz);
+    EXPECT_TRUE(lazy.read_only());
+    EXPECT_EQ(lazy[1].id, 2u);
+    EXPECT_DOUBLE_EQ(lazy[0].tick_size, 0.01);
+    EXPECT_THROW(lazy.push_back({ 3, 1.0 }), std::logic_error);
+
+    auto populated = CustomSTL::mapped_vector<Instrument>::open_read_only(path, CustomSTL::mapped_vector<Instrument>::Paging::Populate);
+    EXPECT_EQ(populated[0].id, 1u);
+
+    // reopening for writing appends to the existing elements
+    {
+        CustomSTL::mapped_vector<Instrument> vec(path);
+        EXPECT_EQ(vec.size(), 2uz);
+        vec.push_back({ 3, 1.0 });
+    }
+    EXPECT_EQ(CustomSTL::mapped_vector<Instrument>::open_read_only(path).size(), 3uz);
+
+    std::filesystem::remove(path);
+}
+
+// Test that the header rejects a file written with a different element type
+TEST(MappedVectorTest, HeaderValidation) {
+    std::string path = temp_path("customstl_mapped_vector_header.bin");
+    {
+        CustomSTL::mapped_vector<int> vec(path);
+        vec.push_back(1);
+    }
+
+    EXPECT_THROW(CustomSTL::mapped_vector<Instrument>::open_read_only(path), std::runtime_error);
+    EXPECT_THROW(CustomSTL::mapped_vector<Instrument> vec(path), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "customSTL/optional.hpp"
+
+// Test construction, access and reset
+TEST(OptionalTest, ValueAndReset) {
+    CustomSTL::optional<int> empty;
+    EXPECT_FALSE(empty);
+    EXPECT_EQ(empty, std::nullopt);
+    EXPECT_THROW(empty.value(), std::bad_optional_access);
+    EXPECT_EQ(empty.value_or(3), 3);
+
+    CustomSTL::optional<int> opt = 42;
+    ASSERT_TRUE(opt.has_value());
+    EXPECT_EQ(*opt, 42);
+    EXPECT_EQ(opt, 42);
+
+    opt = std::nullopt;
+    EXPECT_FALSE(opt);
+    opt.emplace(7);
+    EXPECT_EQ(opt.value(), 7);
+
+    static_assert(std::is_trivially_copyable_v<CustomSTL::optional<int64_t>>);
+}
+
+// Test copy/move semantics of a non trivial type
+TEST(OptionalTest, NonTrivialCopyAndMove) {
+    CustomSTL::optional<std::string> a { std::in_place, 20, 'a' };
+    CustomSTL::optional<std::string> b = a;
+    EXPECT_EQ(*b, std::string(20, 'a'));
+    EXPECT_EQ(a, b);
+
+    CustomSTL::optional<std::string> c = std::move(a);
+    // without the check, optimized GCC builds see the empty path of c-> and warn (-Wmaybe-uninitialized)
+    ASSERT_TRUE(c);
+    EXPECT_EQ(c->size(), 20u);
+
+    CustomSTL::optional<std::string> d;
+    d.swap(c);
+    EXPECT_FALSE(c);
+    EXPECT_EQ(*d, std::string(20, 'a'));
+
+    d = std::string("bid");
+    EXPECT_EQ(*d, "bid");
+    b = d;
+    EXPECT_EQ(*b, "bid");
+    b = CustomSTL::optional<std::string>();
+    EXPECT_FALSE(b);
+}
+
+// Test that compact_optional has no size overhead and uses the sentinel as the empty state
+TEST(OptionalTest, CompactOptional) {
+    static_assert(sizeof(CustomSTL::compact_optional<double>) == sizeof(double));
+    static_assert(sizeof(CustomSTL::compact_optional<int64_t>) == sizeof(int64_t));
+    static_assert(sizeof(CustomSTL::compact_optional<int*>) == sizeof(int*));
+    EXPECT_GT(sizeof(CustomSTL::optional<int64_t>), sizeof(int64_t));
+
+    CustomSTL::compact_optional<double> price;
+    EXPECT_FALSE(price);
+    EXPECT_THROW(price.value(), std::bad_optional_access);
+    price = 101.25;
+    EXPECT_EQ(price.value(), 101.25);
+
+    CustomSTL::compact_optional<int> quantity = 0;
+    EXPECT_TRUE(quantity);
+    quantity = INT_MIN;
+    EXPECT_FALSE(quantity);
+    EXPECT_EQ(quantity.value_or(5), 5);
+
+    int x = 1;
+    CustomSTL::compact_optional<int*> ptr;
+    EXPECT_EQ(ptr, std::nullopt);
+    ptr = &x;
+    EXPECT_EQ(**ptr, 1);
+
+    // custom sentinel, e.g. quantities are never negative
+    CustomSTL::compact_optional<int, CustomSTL::value_sentinel<int, -1>> qty;
+    EXPECT_FALSE(qty);
+    qty = INT_MIN;
+    EXPECT_TRUE(qty);
+
+    std::vector<CustomSTL::compact_optional<double>> prices(4);
+    prices[2] = 99.5;
+    EXPECT_FALSE(prices[0]);
+    EXPECT_EQ(*prices[2], 99.5);
+}
@@ -0,0 +1,124 @@
+#define CUSTOMSTL_REACTOR_METRICS
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "network/epollreactor.hpp"
+#include "network/reactormetrics.hpp"
+
+namespace {
+    struct CountingHandler {
+        explicit CountingHandler(std::atomic<long>* total)
+            : total_bytes { total }
+        { }
+
+        std::atomic<long>* total_bytes;
+
+        int on_data(int, void*, int size) {
+            total_bytes->fetch_add(size);
+            return size;
+        }
+    };
+
+    int connect_to(const std::string& port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(std::stoi(port)));
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    template <typename Condition>
+    bool wait_until(Condition condition) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return condition();
+    }
+}
+
+// Test the log2 buckets and the percentiles derived from them
+TEST(ReactorMetricsTest, Histogram) {
+    network::reactor_metrics::Histogram histogram;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.record(value);
+    }
+    histogram.record(0);
+
+    network::HistogramSnapshot snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 1001u);
+    EXPECT_EQ(snapshot.sum, 500500u);
+    EXPECT_EQ(snapshot.max, 1000u);
+    EXPECT_EQ(snapshot.buckets[0], 1u);
+    EXPECT_EQ(snapshot.buckets[1], 1u);   // 1
+    EXPECT_EQ(snapshot.buckets[2], 2u);   // 2 and 3
+    EXPECT_EQ(snapshot.buckets[10], 489u); // 512 to 1000
+    EXPECT_EQ(snapshot.percentile(0.0), 0u);
+    EXPECT_EQ(snapshot.percentile(0.3), 511u);
+    EXPECT_EQ(snapshot.percentile(0.99), 1000u);
+    EXPECT_NEAR(snapshot.mean(), 500.0, 0.5);
+}
+
+// Test the counters of a running reactor, read from another thread while it runs
+TEST(ReactorMetricsTest, CountsReactorActivity) {
+    std::atomic<long> total { 0 };
+    CountingHandler handler(&total);
+    network::TCPSocket server("0");
+    server.set_non_blocking();
+    server.listen();
+    network::EpollReactor<CountingHandler> reactor(handler);
+    reactor.add_socket(server.get_fd());
+    network::ReactorStats start = reactor.metrics();
+    std::thread loop([&] { reactor.run(server); });
+
+    constexpr int CLIENTS = 3;
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        int client = connect_to(server.get_port());
+        ASSERT_NE(client, -1);
+        ASSERT_EQ(send(client, "hello", 5, 0), 5);
+        clients.push_back(client);
+    }
+    EXPECT_TRUE(wait_until([&] { return total.load() == CLIENTS * 5; }));
+
+    close(clients.back());
+    clients.pop_back();
+    EXPECT_TRUE(wait_until([&] { return reactor.metrics().closed == 1; }));
+    network::ReactorStats stats = reactor.metrics();
+
+    reactor.stop();
+    loop.join();
+
+    EXPECT_EQ(stats.accepted, 3u);
+    EXPECT_EQ(stats.open_connections(), 2u);
+    EXPECT_GT(stats.accept_rate(start), 0.0);
+    EXPECT_EQ(stats.recv_bytes.sum, 15u);
+    EXPECT_EQ(stats.handler_ns.count, stats.recv_bytes.count);
+    // every drain of a socket that stays open ends with EAGAIN
+    EXPECT_EQ(stats.recv_calls, stats.recv_bytes.count + stats.recv_would_block);
+    EXPECT_GE(stats.recv_would_block, 1u);
+    EXPECT_GT(stats.would_block_ratio(), 0.0);
+    EXPECT_LT(stats.would_block_ratio(), 1.0);
+    EXPECT_GE(stats.events_per_wait.count, 2u);
+    EXPECT_GE(stats.events_per_wait.max, 1u);
+    // the snapshot may be taken between the end of a wait and the end of its iteration
+    EXPECT_LE(stats.iteration_ns.count, stats.events_per_wait.count);
+    EXPECT_GE(stats.iteration_ns.count + 1, stats.events_per_wait.count);
+    EXPECT_GT(stats.iteration_ns.sum, 0u);
+
+    for (int client : clients) {
+        close(client);
+    }
+}
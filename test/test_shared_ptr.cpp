@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "customSTL/arena.hpp"
+#include "customSTL/object_pool.hpp"
+#include "customSTL/shared_ptr.hpp"
+#include "customSTL/weak_ptr.hpp"
+
+namespace {
+    struct Tracked {
+        static inline int alive = 0;
+
+        int value;
+
+        explicit Tracked(int v) : value { v } { ++alive; }
+        ~Tracked() { --alive; }
+    };
+
+    struct Base {
+        virtual ~Base() = default;
+        virtual int id() const { return 0; }
+    };
+
+    struct Derived : Base {
+        int id() const override { return 1; }
+    };
+
+    // std::allocator that counts how many allocations it performs
+    template <typename T>
+    struct CountingAllocator {
+        using value_type = T;
+
+        static inline int allocations = 0;
+
+        CountingAllocator() = default;
+
+        template <typename U>
+        CountingAllocator(const CountingAllocator<U>&) noexcept { }
+
+        T* allocate(std::size_t n) {
+            ++CountingAllocator<std::byte>::allocations;
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T* ptr, std::size_t n) noexcept {
+            std::allocator<T>().deallocate(ptr, n);
+        }
+
+        template <typename U>
+        bool operator==(const CountingAllocator<U>&) const noexcept { return true; }
+    };
+}
+
+// Test that copies share ownership and the object is destroyed with the last owner
+TEST(SharedPtrTest, CopyAndRelease) {
+    {
+        CustomSTL::shared_ptr<Tracked> p1 { new Tracked(1) };
+        EXPECT_EQ(p1.use_count(), 1);
+        {
+            CustomSTL::shared_ptr<Tracked> p2 = p1;
+            EXPECT_EQ(p1.use_count(), 2);
+            EXPECT_EQ(p2->value, 1);
+        }
+        EXPECT_EQ(p1.use_count(), 1);
+        EXPECT_EQ(Tracked::alive, 1);
+
+        CustomSTL::shared_ptr<Tracked> p3 = std::move(p1);
+        EXPECT_FALSE(p1);
+        EXPECT_EQ(p3.use_count(), 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+// Test that a shared_ptr<Base> created from a Derived calls the correct destructor and custom deleters
+TEST(SharedPtrTest, ConversionAndDeleter) {
+    CustomSTL::shared_ptr<Derived> derived { new Derived() };
+    CustomSTL::shared_ptr<Base> base = derived;
+    EXPECT_EQ(base->id(), 1);
+    EXPECT_EQ(base.use_count(), 2);
+
+    int deleted = 0;
+    {
+        CustomSTL::shared_ptr<int> p { new int(5), [&deleted](int* ptr) { ++deleted; delete ptr; } };
+    }
+    EXPECT_EQ(deleted, 1);
+}
+
+// Test that make_shared and allocate_shared only perform a single allocation
+TEST(SharedPtrTest, MakeSharedSingleAllocation) {
+    {
+        auto p = CustomSTL::make_shared<Tracked>(42);
+        EXPECT_EQ(p->value, 42);
+        EXPECT_EQ(p.use_count(), 1);
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+
+    CountingAllocator<std::byte>::allocations = 0;
+    {
+        auto p = CustomSTL::allocate_shared<Tracked>(CountingAllocator<Tracked>(), 7);
+        auto copy = p;
+        EXPECT_EQ(copy->value, 7);
+    }
+    EXPECT_EQ(CountingAllocator<std::byte>::allocations, 1);
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+// Test that allocate_shared can take its memory from an Arena or an ObjectPool
+TEST(SharedPtrTest, AllocateSharedFromArenaAndPool) {
+    CustomSTL::Arena arena(256);
+    {
+        auto p = CustomSTL::allocate_shared<Tracked>(CustomSTL::arena_allocator<Tracked>(arena), 3);
+        EXPECT_EQ(p->value, 3);
+        EXPECT_LT(arena.remaining(), 256uz);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+
+    using Block = CustomSTL::shared_block<Tracked, CustomSTL::pool_allocator<Tracked>>;
+    CustomSTL::ObjectPool<Block> pool(1);
+    CustomSTL::pool_allocator<Tracked> alloc(pool);
+    {
+        auto p = CustomSTL::allocate_shared<Tracked>(alloc, 4);
+        EXPECT_EQ(p->value, 4);
+
+        // the only slot is in use
+        EXPECT_THROW(CustomSTL::allocate_shared<Tracked>(alloc, 5), std::bad_alloc);
+    }
+
+    // the slot was returned to the pool
+    auto p = CustomSTL::allocate_shared<Tracked>(alloc, 6);
+    EXPECT_EQ(p->value, 6);
+}
+
+// Test that local_shared_ptr has the same ownership semantics with non atomic counts
+TEST(SharedPtrTest, LocalSharedPtr) {
+    static_assert(std::is_same_v<CustomSTL::local_shared_ptr<int>::control_block::count_size, unsigned long>);
+    {
+        auto p1 = CustomSTL::make_local_shared<Tracked>(8);
+        auto p2 = p1;
+        EXPECT_EQ(p1.use_count(), 2);
+        p1.reset();
+        EXPECT_EQ(p2.use_count(), 1);
+        EXPECT_EQ(p2->value, 8);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+// Test that sharded counts stay exact while references move between threads
+TEST(SharedPtrTest, ShardedSharedPtr) {
+    {
+        auto source = CustomSTL::make_sharded_shared<Tracked>(9);
+        CustomSTL::weak_ptr<Tracked, CustomSTL::sharded_count_policy<>> weak = source;
+
+        // every thread copies the source, and drops copies made by the next thread (so decrements hit other shards)
+        constexpr int THREADS = 4;
+        constexpr int COPIES = 10000;
+        std::vector<std::vector<CustomSTL::sharded_shared_ptr<Tracked>>> copies(THREADS);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < COPIES; ++i) {
+                    copies[t].push_back(source);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(source.use_count(), THREADS * COPIES + 1);
+
+        threads.clear();
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&, t] {
+                copies[(t + 1) % THREADS].clear();
+                EXPECT_TRUE(weak.lock());
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(source.use_count(), 1);
+        EXPECT_EQ(Tracked::alive, 1);
+
+        source.reset();
+        EXPECT_EQ(Tracked::alive, 0);
+        EXPECT_TRUE(weak.expired());
+        EXPECT_FALSE(weak.lock());
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "customSTL/lock_guard.hpp"
+#include "customSTL/spinlock.hpp"
+#include "customSTL/unique_lock.hpp"
+
+template <typename Lock>
+class SpinlockTest : public ::testing::Test { };
+
+using LockTypes = ::testing::Types<CustomSTL::spinlock, CustomSTL::ticket_lock, CustomSTL::mcs_lock>;
+TYPED_TEST_SUITE(SpinlockTest, LockTypes);
+
+// Test that every lock can be used with lock_guard/unique_lock, including the timed constructors
+TYPED_TEST(SpinlockTest, Requirements) {
+    static_assert(CustomSTL::TimedLockable<TypeParam>);
+    // lock profiling is compiled out, the guards hold nothing but the mutex
+    static_assert(sizeof(CustomSTL::lock_guard<TypeParam>) == sizeof(TypeParam*));
+
+    TypeParam lock;
+    {
+        CustomSTL::unique_lock<TypeParam> guard(lock);
+        EXPECT_TRUE(guard.owns_lock());
+        EXPECT_FALSE(lock.try_lock());
+
+        std::thread other([&] {
+            CustomSTL::unique_lock<TypeParam> timed(lock, std::chrono::milliseconds(5));
+            EXPECT_FALSE(timed.owns_lock());
+        });
+        other.join();
+    }
+
+    CustomSTL::unique_lock<TypeParam> try_guard(lock, std::try_to_lock);
+    EXPECT_TRUE(try_guard);
+    try_guard.unlock();
+    EXPECT_TRUE(try_guard.try_lock_for(std::chrono::milliseconds(1)));
+}
+
+// Test mutual exclusion under contention
+TYPED_TEST(SpinlockTest, MutualExclusion) {
+    TypeParam lock;
+    long counter = 0;
+
+    constexpr int THREADS = 4;
+    constexpr int INCREMENTS = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < INCREMENTS; ++i) {
+                CustomSTL::lock_guard<TypeParam> guard(lock);
+                ++counter;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(counter, THREADS * INCREMENTS);
+}
+
+// Test that a thread can hold several MCS locks at once and release them in any order
+TEST(McsLockTest, NestedLocks) {
+    CustomSTL::mcs_lock a;
+    CustomSTL::mcs_lock b;
+    a.lock();
+    b.lock();
+    a.unlock();
+    EXPECT_TRUE(a.try_lock());
+    b.unlock();
+    a.unlock();
+}
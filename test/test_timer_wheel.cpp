@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "network/timerwheel.hpp"
+
+using namespace std::chrono_literals;
+using network::TimerWheel;
+
+// Test timers on every level and beyond the wheel's range: each one fires at the first advance past its deadline,
+// never before, and at most one tick later
+TEST(TimerWheelTest, FiresOnTime) {
+    TimerWheel::Clock::time_point start {};
+    TimerWheel wheel(1ms, start);
+
+    std::vector<std::chrono::milliseconds> delays { 0ms, 1ms, 5ms, 63ms, 64ms, 65ms, 200ms, 4095ms, 4096ms, 4097ms,
+                                                    300000ms, 20000000ms };
+    std::mt19937 random(42);
+    for (int i = 0; i < 200; ++i) {
+        delays.push_back(std::chrono::milliseconds(random() % 100000));
+    }
+
+    std::vector<TimerWheel::Clock::time_point> fired(delays.size());
+    for (size_t i = 0; i < delays.size(); ++i) {
+        wheel.schedule(delays[i], [&fired, &wheel, i] { fired[i] = wheel.now(); });
+    }
+    EXPECT_EQ(wheel.size(), delays.size());
+
+    // uneven steps, so that advances skip ticks and cross cascades in the middle of a step
+    TimerWheel::Clock::time_point now = start;
+    while (!wheel.empty()) {
+        now += std::chrono::microseconds(random() % 900000);
+        wheel.advance(now);
+        for (size_t i = 0; i < delays.size(); ++i) {
+            if (fired[i] == now) {
+                EXPECT_GE(now, start + delays[i]);
+                EXPECT_LT(now - std::chrono::microseconds(900000), start + delays[i] + 1ms) << delays[i].count();
+            }
+        }
+    }
+
+    // small steps: a timer runs within a tick of its deadline
+    wheel.schedule(70000ms, [&] { fired[0] = wheel.now(); });
+    TimerWheel::Clock::time_point due = now + 70000ms;
+    while (!wheel.empty()) {
+        now += 100us;
+        wheel.advance(now);
+    }
+    EXPECT_GE(fired[0], due);
+    EXPECT_LE(fired[0], due + 1ms);
+}
+
+// Test cancel and reschedule, including stale handles and callbacks changing their own timer
+TEST(TimerWheelTest, CancelAndReschedule) {
+    TimerWheel::Clock::time_point start {};
+    TimerWheel wheel(1ms, start);
+
+    int first = 0;
+    int second = 0;
+    TimerWheel::TimerId a = wheel.schedule(10ms, [&] { ++first; });
+    TimerWheel::TimerId b = wheel.schedule(10ms, [&] { ++second; });
+    EXPECT_TRUE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(a));
+    EXPECT_TRUE(wheel.reschedule(b, 100ms));
+    EXPECT_EQ(wheel.advance(start + 50ms), 0u);
+    EXPECT_EQ(wheel.advance(start + 100ms), 1u);
+    EXPECT_EQ(first, 0);
+    EXPECT_EQ(second, 1);
+    EXPECT_FALSE(wheel.cancel(b));
+    EXPECT_FALSE(wheel.reschedule(b, 1ms));
+
+    // the nodes are reused, the old handles stay stale
+    TimerWheel::TimerId c = wheel.schedule(1ms, [&] { ++first; });
+    EXPECT_FALSE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(b));
+    EXPECT_TRUE(wheel.cancel(c));
+    EXPECT_EQ(wheel.node_count(), 2u);
+
+    // a periodic timer reschedules itself, and stops by cancelling itself
+    int ticks = 0;
+    TimerWheel::TimerId periodic;
+    periodic = wheel.schedule(10ms, [&] {
+        if (++ticks < 5) {
+            wheel.reschedule(periodic, 10ms);
+        } else {
+            wheel.reschedule(periodic, 10ms);
+            wheel.cancel(periodic);
+        }
+    });
+    for (int ms = 101; ms <= 300; ++ms) {
+        wheel.advance(start + std::chrono::milliseconds(ms));
+    }
+    EXPECT_EQ(ticks, 5);
+    EXPECT_TRUE(wheel.empty());
+
+    // a callback cancelling a timer of the same batch
+    TimerWheel::TimerId later;
+    wheel.schedule(5ms, [&] { EXPECT_TRUE(wheel.cancel(later)); });
+    later = wheel.schedule(5ms, [&] { ++second; });
+    EXPECT_EQ(wheel.advance(start + 400ms), 1u);
+    EXPECT_EQ(second, 1);
+    EXPECT_LE(wheel.node_count(), 3u);
+}
+
+// Test the timeout until the next timer, used to block in epoll_wait for the right amount of time
+TEST(TimerWheelTest, NextTimeout) {
+    TimerWheel::Clock::time_point start {};
+    TimerWheel wheel(1ms, start);
+    EXPECT_EQ(wheel.next_timeout(), TimerWheel::Clock::duration::max());
+
+    wheel.schedule(10ms, [] { });
+    EXPECT_EQ(wheel.next_timeout(), 10ms);
+    wheel.advance(start + 4500us);
+    EXPECT_EQ(wheel.next_timeout(), 5500us);
+
+    // a timer above level 0 is only known to be due after the next cascade, never later than its deadline
+    TimerWheel::TimerId far = wheel.schedule(1000ms, [] { });
+    wheel.advance(start + 10ms);
+    TimerWheel::Clock::duration timeout = wheel.next_timeout();
+    EXPECT_GT(timeout, 0ms);
+    EXPECT_LE(timeout, 1000ms);
+    int wakeups = 0;
+    while (!wheel.empty()) {
+        wheel.advance(wheel.now() + wheel.next_timeout());
+        ++wakeups;
+    }
+    EXPECT_LE(wakeups, 20);
+    EXPECT_FALSE(wheel.cancel(far));
+}
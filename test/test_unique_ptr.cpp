@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
-#include "CustomSTL/unique_ptr.hpp"
+#include "customSTL/arena.hpp"
+#include "customSTL/object_pool.hpp"
+#include "customSTL/unique_ptr.hpp"
 
 // Test if operator bool() & default constructor works correctly
 TEST(UniquePtrTest, DefaultConstructor) {
@@ -46,4 +48,130 @@ TEST(UniquePtrTest, ResetAndRelease) {
     EXPECT_EQ(*raw, 10);
     EXPECT_FALSE(p);
     delete raw;
-}
\ No newline at end of file
+}
+namespace {
+    struct Shape {
+        static inline int alive = 0;
+
+        Shape() { ++alive; }
+        Shape(const Shape&) { ++alive; }
+        Shape(Shape&&) noexcept { ++alive; }
+        virtual ~Shape() { --alive; }
+        virtual int area() const = 0;
+    };
+
+    struct Square : Shape {
+        int side;
+        explicit Square(int s) : side { s } { }
+        int area() const override { return side * side; }
+    };
+
+    // too large for the default 64 byte buffer
+    struct BigRectangle : Shape {
+        int width;
+        int height;
+        char padding[128] {};
+        BigRectangle(int w, int h) : width { w }, height { h } { }
+        int area() const override { return width * height; }
+    };
+
+    // Shape is not the first base, so the Shape* does not point to the start of the object
+    struct Tagged {
+        long tag = 7;
+        virtual ~Tagged() = default;
+    };
+
+    struct TaggedSquare : Tagged, Square {
+        using Square::Square;
+    };
+}
+
+// Test that derived objects are stored inline or on the heap and are moved as a whole
+TEST(SmallUniquePtrTest, PolymorphicInlineAndHeap) {
+    {
+        auto square = CustomSTL::make_small_unique<Shape, Square>(3);
+        auto big = CustomSTL::make_small_unique<Shape, BigRectangle>(2, 5);
+        EXPECT_TRUE(square.is_constructed_inline());
+        EXPECT_FALSE(big.is_constructed_inline());
+        EXPECT_EQ(square->area(), 9);
+        EXPECT_EQ(big->area(), 10);
+
+        CustomSTL::small_unique_ptr<Shape> moved { std::move(square) };
+        EXPECT_FALSE(square);
+        EXPECT_TRUE(moved.is_constructed_inline());
+        EXPECT_EQ(moved->area(), 9);
+
+        Shape* heap_object = big.get();
+        moved = std::move(big);
+        EXPECT_EQ(moved.get(), heap_object);
+        EXPECT_EQ(moved->area(), 10);
+        EXPECT_EQ(Shape::alive, 1);
+    }
+    EXPECT_EQ(Shape::alive, 0);
+}
+
+// Test converting moves and that the offset of the base subobject is preserved
+TEST(SmallUniquePtrTest, ConvertingMoveAndSwap) {
+    {
+        CustomSTL::small_unique_ptr<TaggedSquare> derived { 4 };
+        CustomSTL::small_unique_ptr<Shape> base { std::move(derived) };
+        EXPECT_EQ(base->area(), 16);
+        EXPECT_EQ(dynamic_cast<Tagged*>(base.get())->tag, 7);
+
+        auto other = CustomSTL::make_small_unique<Shape, BigRectangle>(1, 2);
+        base.swap(other);
+        EXPECT_EQ(base->area(), 2);
+        EXPECT_EQ(other->area(), 16);
+        EXPECT_EQ(Shape::alive, 2);
+    }
+    EXPECT_EQ(Shape::alive, 0);
+}
+
+namespace {
+    struct Order {
+        static inline int alive = 0;
+
+        long id;
+        explicit Order(long i) : id { i } { ++alive; }
+        ~Order() { --alive; }
+    };
+
+    CustomSTL::ObjectPool<Order> global_order_pool(2);
+}
+
+// Test that pooled handles give their slot back and stateless deleters keep unique_ptr pointer sized
+TEST(UniquePtrTest, PoolAndArenaDeleters) {
+    static_assert(sizeof(CustomSTL::pool_unique_ptr<Order>) == 2 * sizeof(void*));
+    static_assert(sizeof(CustomSTL::arena_unique_ptr<Order>) == sizeof(void*));
+    static_assert(sizeof(CustomSTL::unique_ptr<Order, CustomSTL::static_pool_deleter<Order, global_order_pool>>) == sizeof(void*));
+
+    CustomSTL::ObjectPool<Order> pool(1);
+    {
+        auto order = CustomSTL::make_unique_from(pool, 1);
+        ASSERT_TRUE(order);
+        EXPECT_EQ(order->id, 1);
+        EXPECT_FALSE(CustomSTL::make_unique_from(pool, 2));
+
+        order.reset();
+        EXPECT_EQ(Order::alive, 0);
+        EXPECT_TRUE(CustomSTL::make_unique_from(pool, 3));
+    }
+
+    {
+        auto a = CustomSTL::make_unique_from<Order, global_order_pool>(4);
+        auto b = CustomSTL::make_unique_from<Order, global_order_pool>(5);
+        EXPECT_FALSE((CustomSTL::make_unique_from<Order, global_order_pool>(6)));
+        b = std::move(a);
+        EXPECT_EQ(b->id, 4);
+        EXPECT_EQ(Order::alive, 1);
+    }
+
+    CustomSTL::Arena arena(256);
+    {
+        auto order = CustomSTL::make_unique_from<Order>(arena, 7);
+        EXPECT_EQ(order->id, 7);
+        EXPECT_EQ(Order::alive, 1);
+    }
+    EXPECT_EQ(Order::alive, 0);
+    arena.reset();
+}
@@ -0,0 +1,342 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "network/iouring.hpp"
+#include "network/multireactor.hpp"
+#include "network/outputbuffer.hpp"
+#include "network/uringreactor.hpp"
+
+namespace {
+    // consumes everything it receives and counts it
+    struct CountingHandler {
+        explicit CountingHandler(std::atomic<long>* total)
+            : total_bytes { total }
+        { }
+
+        std::atomic<long>* total_bytes;
+        long bytes = 0;
+
+        int on_data(int, void*, int size) {
+            bytes += size;
+            total_bytes->fetch_add(size);
+            return size;
+        }
+    };
+
+    // echoes every byte it receives, "b" answers with BIG_REPLY bytes
+    struct ReplyingHandler {
+        static constexpr size_t BIG_REPLY = 8 * 1024 * 1024;
+
+        int on_data(int, void* buf, int size, network::OutputBuffer& out) {
+            const char* bytes = static_cast<const char*>(buf);
+            for (int i = 0; i < size; ++i) {
+                if (bytes[i] == 'b') {
+                    std::vector<char> reply(BIG_REPLY, 'b');
+                    out.append(reply.data(), reply.size());
+                } else {
+                    out.append(&bytes[i], 1);
+                }
+            }
+            return size;
+        }
+    };
+
+    // messages are a 4 byte length followed by the payload, only complete messages are consumed
+    struct FramedHandler {
+        explicit FramedHandler(std::atomic<long>* messages)
+            : total_messages { messages }
+        { }
+
+        int on_data(int, void* buf, int size) {
+            const char* bytes = static_cast<const char*>(buf);
+            int consumed = 0;
+            while (size - consumed >= 4) {
+                uint32_t length;
+                std::memcpy(&length, bytes + consumed, 4);
+                if (size - consumed - 4 < static_cast<int>(length)) {
+                    break;
+                }
+                consumed += 4 + length;
+                total_messages->fetch_add(1);
+            }
+            return consumed;
+        }
+
+        std::atomic<long>* total_messages;
+    };
+
+    int connect_to(const std::string& port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(std::stoi(port)));
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool wait_for(const std::atomic<long>& value, long expected) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (value.load() != expected && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return value.load() == expected;
+    }
+
+    bool receive_all(int fd, std::vector<char>& received) {
+        size_t offset = 0;
+        while (offset < received.size()) {
+            ssize_t rc = recv(fd, received.data() + offset, received.size() - offset, 0);
+            if (rc <= 0) {
+                return false;
+            }
+            offset += rc;
+        }
+        return true;
+    }
+}
+
+// Test that a reactor receives data from many clients over several chunks and that stop() ends run()
+TEST(UringReactorTest, ReceiveAndStop) {
+    if (!network::io_uring_supported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+
+    std::atomic<long> total { 0 };
+    CountingHandler handler(&total);
+    network::TCPSocket server("0");
+    server.listen();
+    network::UringReactor<CountingHandler> reactor(handler);
+    reactor.add_socket(server.get_fd());
+    std::thread loop([&] { reactor.run(server); });
+
+    constexpr int CLIENTS = 20;
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        int client = connect_to(server.get_port());
+        ASSERT_NE(client, -1);
+        clients.push_back(client);
+    }
+    for (int round = 0; round < 10; ++round) {
+        for (int client : clients) {
+            ASSERT_EQ(send(client, "hello", 5, 0), 5);
+        }
+    }
+    EXPECT_TRUE(wait_for(total, CLIENTS * 10 * 5));
+
+    reactor.stop();
+    loop.join();
+    EXPECT_EQ(handler.bytes, CLIENTS * 10 * 5);
+    for (int client : clients) {
+        close(client);
+    }
+}
+
+// Test that replies are sent back in order, including one much larger than the socket buffer (partial sends)
+TEST(UringReactorTest, BufferedReplies) {
+    if (!network::io_uring_supported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+
+    ReplyingHandler handler;
+    network::TCPSocket server("0");
+    server.listen();
+    network::UringReactor<ReplyingHandler> reactor(handler);
+    std::thread loop([&] { reactor.run(server); });
+
+    int client = connect_to(server.get_port());
+    ASSERT_NE(client, -1);
+    ASSERT_EQ(send(client, "xbx", 3, 0), 3);
+
+    std::vector<char> received(ReplyingHandler::BIG_REPLY + 2);
+    ASSERT_TRUE(receive_all(client, received));
+    EXPECT_EQ(received.front(), 'x');
+    EXPECT_EQ(received[1], 'b');
+    EXPECT_EQ(received[received.size() - 2], 'b');
+    EXPECT_EQ(received.back(), 'x');
+
+    // a closed connection is shut down and its fd reused for the next one
+    close(client);
+    client = connect_to(server.get_port());
+    ASSERT_NE(client, -1);
+    ASSERT_EQ(send(client, "xx", 2, 0), 2);
+    std::vector<char> echo(2);
+    ASSERT_TRUE(receive_all(client, echo));
+    EXPECT_EQ(std::string(echo.data(), 2), "xx");
+
+    reactor.stop();
+    loop.join();
+    close(client);
+}
+
+// Test that unconsumed bytes are kept across completions, also for messages larger than a provided buffer, and that
+// the connection buffers are given back once every message was consumed
+TEST(UringReactorTest, PartialMessages) {
+    if (!network::io_uring_supported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+
+    std::atomic<long> messages { 0 };
+    FramedHandler handler(&messages);
+    network::TCPSocket server("0");
+    server.listen();
+    // few small buffers, so that the kernel runs out of them and the recv has to be rearmed
+    network::UringReactor<FramedHandler> reactor(handler, { .buffer_count = 4, .buffer_size = 4096 });
+    std::thread loop([&] { reactor.run(server); });
+
+    constexpr int CLIENTS = 8;
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        int client = connect_to(server.get_port());
+        ASSERT_NE(client, -1);
+        uint32_t length = 3;
+        ASSERT_EQ(send(client, &length, 4, 0), 4);
+        ASSERT_EQ(send(client, "ab", 2, 0), 2);
+        clients.push_back(client);
+    }
+    for (int client : clients) {
+        ASSERT_EQ(send(client, "c", 1, 0), 1);
+    }
+    EXPECT_TRUE(wait_for(messages, CLIENTS));
+
+    std::vector<char> message(4 + 1024 * 1024, 'm');
+    uint32_t length = message.size() - 4;
+    std::memcpy(message.data(), &length, 4);
+    for (int client : clients) {
+        size_t offset = 0;
+        while (offset < message.size()) {
+            ssize_t rc = send(client, message.data() + offset, message.size() - offset, 0);
+            ASSERT_GT(rc, 0);
+            offset += rc;
+        }
+    }
+    EXPECT_TRUE(wait_for(messages, 2 * CLIENTS));
+
+    reactor.stop();
+    loop.join();
+    EXPECT_EQ(reactor.buffer_pool().blocks_in_use(), 0u);
+    EXPECT_EQ(reactor.input_buffers().in_use(), 0u);
+    for (int client : clients) {
+        close(client);
+    }
+}
+
+// Test that running out of file descriptors pauses accepting instead of ending run(), and that the connections
+// waiting in the backlog are accepted once descriptors are available again
+TEST(UringReactorTest, AcceptOutOfDescriptors) {
+    if (!network::io_uring_supported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+
+    std::atomic<long> total { 0 };
+    CountingHandler handler(&total);
+    network::TCPSocket server("0");
+    server.listen();
+    network::UringReactor<CountingHandler> reactor(handler);
+    std::thread loop([&] { reactor.run(server); });
+
+    // the client socket is created first, the reactor then has no descriptor left for the accepted one
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_NE(client, -1);
+    rlimit limits;
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limits), 0);
+    int lowest_free = open("/dev/null", O_RDONLY);
+    ASSERT_NE(lowest_free, -1);
+    close(lowest_free);
+    rlimit lowered = limits;
+    lowered.rlim_cur = lowest_free;
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &lowered), 0);
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(std::stoi(server.get_port())));
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_EQ(send(client, "hello", 5, 0), 5);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(total.load(), 0);
+
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limits), 0);
+    EXPECT_TRUE(wait_for(total, 5));
+
+    reactor.stop();
+    loop.join();
+    close(client);
+}
+
+// Test a completion queue that overflows while the submission queue is full, including a handler that submits
+// during for_each_completion: every completion is handed out once and in order
+TEST(UringReactorTest, CompletionOverflow) {
+    if (!network::io_uring_supported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    network::IoUring ring(network::IoUring::Options { .entries = 4 }); // 16 completions fit in the ring
+    uint64_t submitted = 0;
+    auto submit_nop = [&] {
+        struct io_uring_sqe& sqe = ring.get_sqe();
+        sqe.opcode = IORING_OP_NOP;
+        sqe.user_data = submitted++;
+    };
+
+    for (int i = 0; i < 100; ++i) {
+        submit_nop();
+    }
+    std::vector<uint64_t> seen;
+    for (int round = 0; round < 1000 && seen.size() < 200; ++round) {
+        ring.submit(ring.ready() == 0 ? 1 : 0);
+        ring.for_each_completion([&](const struct io_uring_cqe& cqe) {
+            seen.push_back(cqe.user_data);
+            if (submitted < 200) {
+                submit_nop();
+            }
+        });
+    }
+
+    ASSERT_EQ(seen.size(), 200u);
+    for (uint64_t i = 0; i < seen.size(); ++i) {
+        EXPECT_EQ(seen[i], i);
+    }
+    EXPECT_EQ(ring.ready(), 0u);
+}
+
+// Test a MultiReactor running io_uring reactors
+TEST(UringReactorTest, MultiReactor) {
+    if (!network::io_uring_supported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+
+    std::atomic<long> total { 0 };
+    network::MultiReactor<CountingHandler, network::UringReactor<CountingHandler>> reactors(
+        "0", 2, [&](size_t) { return CountingHandler(&total); });
+    reactors.start();
+
+    constexpr int CLIENTS = 16;
+    std::vector<int> clients;
+    for (int i = 0; i < CLIENTS; ++i) {
+        int client = connect_to(reactors.get_port());
+        ASSERT_NE(client, -1);
+        ASSERT_EQ(send(client, "ping", 4, 0), 4);
+        clients.push_back(client);
+    }
+    EXPECT_TRUE(wait_for(total, CLIENTS * 4));
+
+    reactors.stop();
+    reactors.join();
+    EXPECT_EQ(reactors.handler(0).bytes + reactors.handler(1).bytes, CLIENTS * 4);
+    for (int client : clients) {
+        close(client);
+    }
+}
@@ -1,5 +1,5 @@
 #include <gtest/gtest.h>
-#include "CustomSTL/vector.hpp"
+#include "customSTL/vector.hpp"
 
 TEST(VectorTest, Realloc) {
     CustomSTL::vector<int> vec;
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "customSTL/shared_ptr.hpp"
+#include "customSTL/weak_cache.hpp"
+#include "customSTL/weak_ptr.hpp"
+
+namespace {
+    struct Instrument {
+        static inline int alive = 0;
+
+        std::string symbol;
+
+        explicit Instrument(std::string s) : symbol { std::move(s) } { ++alive; }
+        ~Instrument() { --alive; }
+    };
+}
+
+// Test that lock() only succeeds while the object is alive and the block outlives the object
+TEST(WeakPtrTest, LockAndExpire) {
+    CustomSTL::weak_ptr<int> weak;
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(weak.lock());
+
+    {
+        auto strong = CustomSTL::make_shared<int>(5);
+        weak = strong;
+        EXPECT_EQ(weak.use_count(), 1);
+
+        auto locked = weak.lock();
+        ASSERT_TRUE(locked);
+        EXPECT_EQ(*locked, 5);
+        EXPECT_EQ(strong.use_count(), 2);
+
+        CustomSTL::weak_ptr<int> copy = weak;
+        EXPECT_FALSE(copy.owner_before(weak) || weak.owner_before(copy));
+    }
+
+    EXPECT_TRUE(weak.expired());
+    EXPECT_FALSE(weak.lock());
+    weak.reset();
+}
+
+// Test that a weak_ptr to a local_shared_ptr uses the same policy
+TEST(WeakPtrTest, LocalPolicy) {
+    auto strong = CustomSTL::make_local_shared<int>(1);
+    CustomSTL::weak_ptr<int, CustomSTL::local_count_policy> weak = strong;
+    EXPECT_EQ(*weak.lock(), 1);
+    strong.reset();
+    EXPECT_TRUE(weak.expired());
+}
+
+// Test that the cache deduplicates live objects and lets them expire once unused
+TEST(WeakCacheTest, DeduplicateAndExpire) {
+    CustomSTL::weak_cache<int, Instrument> cache;
+    {
+        auto a = cache.get_or_emplace(1, "AAPL");
+        auto b = cache.get_or_emplace(1, "ignored, already cached");
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(b->symbol, "AAPL");
+        EXPECT_EQ(Instrument::alive, 1);
+
+        auto c = cache.get_or_create(2, [] { return CustomSTL::make_shared<Instrument>("MSFT"); });
+        EXPECT_EQ(Instrument::alive, 2);
+        EXPECT_EQ(cache.find(2), c);
+    }
+
+    // the cache does not keep objects alive
+    EXPECT_EQ(Instrument::alive, 0);
+    EXPECT_FALSE(cache.find(1));
+    EXPECT_EQ(cache.size(), 2uz);
+
+    cache.purge_expired();
+    EXPECT_EQ(cache.size(), 0uz);
+
+    // an expired key is recreated on the next request
+    auto d = cache.get_or_emplace(1, "AAPL");
+    EXPECT_EQ(Instrument::alive, 1);
+}
+
+// Test that the factory runs without the cache lock held, so it can look up and fill the same cache
+TEST(WeakCacheTest, FactoryUsesCache) {
+    CustomSTL::weak_cache<int, Instrument> cache;
+
+    auto base = cache.get_or_emplace(1, "AAPL");
+    auto derived = cache.get_or_create(2, [&] {
+        EXPECT_EQ(cache.find(1), base);
+        auto option = cache.get_or_emplace(3, "AAPL option");
+        return CustomSTL::make_shared<Instrument>(cache.find(1)->symbol + " future");
+    });
+
+    EXPECT_EQ(derived->symbol, "AAPL future");
+    EXPECT_EQ(cache.find(2), derived);
+
+    // a factory that fills its own key first loses: the object already cached is returned instead
+    auto winner = CustomSTL::shared_ptr<const Instrument>();
+    auto result = cache.get_or_create(4, [&] {
+        winner = cache.get_or_emplace(4, "first");
+        return CustomSTL::make_shared<Instrument>("second");
+    });
+
+    EXPECT_EQ(result, winner);
+    EXPECT_EQ(result->symbol, "first");
+    EXPECT_EQ(Instrument::alive, 3);
+}